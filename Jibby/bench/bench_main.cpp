@@ -0,0 +1,483 @@
+#include "json.h"
+#include "json_lines_reader.h"
+#include "json_parser.h"
+#include "json_push_parser.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using jibby::Json;
+using jibby::JsonParser;
+
+// ---- Allocation counting ----
+// Every heap allocation in the process goes through these, so each result can report how many
+// allocations one iteration of it made
+
+namespace {
+
+std::atomic<size_t> allocationCount{0};
+
+// Aligned blocks are over-allocated from malloc, with the address malloc returned stored just
+// before the aligned one so the block can be freed without a platform-specific aligned free
+void* allocateAligned(size_t size, size_t alignment) {
+    void* raw = std::malloc(size + alignment + sizeof(void*));
+    if (raw == nullptr) throw std::bad_alloc();
+    const uintptr_t start = reinterpret_cast<uintptr_t>(raw) + sizeof(void*);
+    void* aligned = reinterpret_cast<void*>((start + alignment - 1) & ~(uintptr_t(alignment) - 1));
+    static_cast<void**>(aligned)[-1] = raw;
+    return aligned;
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    ++allocationCount;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    ++allocationCount;
+    return allocateAligned(size, static_cast<size_t>(alignment));
+}
+
+// GCC does not see that the replaced operator new above allocates with malloc
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas" // the warning below is new in GCC 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { if (p) std::free(static_cast<void**>(p)[-1]); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { if (p) std::free(static_cast<void**>(p)[-1]); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+// ---- Corpora ----
+// Generated from a fixed seed with integer arithmetic only, so every platform and every build
+// benchmarks byte-identical text
+
+class Random {
+    public:
+        explicit Random(uint64_t seed) : state(seed) {}
+
+        uint64_t next() {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return state * 0x2545F4914F6CDD1DULL;
+        }
+
+        uint64_t below(uint64_t bound) { return next() % bound; }
+        bool chance(unsigned percent) { return below(100) < percent; }
+
+        // A decimal with the given digits after the point, within [low, high)
+        std::string decimal(int64_t low, int64_t high, int digits) {
+            uint64_t scale = 1;
+            for (int i = 0; i < digits; ++i) scale *= 10;
+            const uint64_t fraction = below(scale);
+            const int64_t whole = low + static_cast<int64_t>(below(static_cast<uint64_t>(high - low)));
+            std::string text = whole < 0 ? "-" : "";
+            text += std::to_string(whole < 0 ? -whole : whole) + ".";
+            std::string tail = std::to_string(fraction);
+            text += std::string(static_cast<size_t>(digits) - tail.size(), '0') + tail;
+            return text;
+        }
+
+        template <typename T>
+        const T& pick(const std::vector<T>& items) { return items[below(items.size())]; }
+
+    private:
+        uint64_t state;
+};
+
+// Non-ASCII words are spelled as UTF-8 bytes, so the text does not depend on the source charset
+const std::vector<std::string> WORDS = {
+    "json", "parse", "fast", "value", "stream", "the", "of", "and", "data", "record", "latency",
+    "\xe6\x9d\xb1\xe4\xba\xac", "caf\xc3\xa9", "na\xc3\xafve", "\xc3\xbc" "ber", "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e", "\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88", "emoji", "\xf0\x9f\x91\x8d", "\xf0\x9f\x9a\x80", "reply", "update", "release"
+};
+
+std::string quoted(const std::string& text) {
+    return "\"" + text + "\"";
+}
+
+std::string sentence(Random& random, size_t words) {
+    std::string text;
+    for (size_t i = 0; i < words; ++i) {
+        if (i > 0) text += ' ';
+        text += random.pick(WORDS);
+    }
+    return text;
+}
+
+// Mixed document shaped like the Twitter search API: nested objects, long ids, Unicode text
+std::string twitterCorpus(size_t scale) {
+    Random random(1);
+    std::string out = "{\"statuses\":[";
+    for (size_t i = 0; i < 500 * scale; ++i) {
+        if (i > 0) out += ',';
+        const std::string id = std::to_string(505874924095815681ULL + random.below(1000000000));
+        out += "{\"created_at\":\"Sun Aug 31 00:29:15 +0000 2014\",\"id\":" + id + ",\"id_str\":" + quoted(id);
+        out += ",\"text\":" + quoted(sentence(random, 4 + random.below(16)));
+        out += ",\"source\":\"<a href=\\\"http://twitter.com/download/iphone\\\" rel=\\\"nofollow\\\">Twitter for iPhone</a>\"";
+        out += ",\"truncated\":false,\"in_reply_to_status_id\":";
+        out += random.chance(30) ? std::to_string(random.next() >> 8) : "null";
+        out += ",\"user\":{\"id\":" + std::to_string(random.below(3000000000ULL));
+        out += ",\"name\":" + quoted(sentence(random, 2)) + ",\"screen_name\":" + quoted(random.pick(WORDS) + std::to_string(i));
+        out += ",\"location\":" + quoted(random.pick(WORDS)) + ",\"description\":" + quoted(sentence(random, 12));
+        out += ",\"followers_count\":" + std::to_string(random.below(100000));
+        out += ",\"friends_count\":" + std::to_string(random.below(5000));
+        out += ",\"verified\":" + std::string(random.chance(5) ? "true" : "false");
+        out += ",\"profile_image_url\":\"http://pbs.twimg.com/profile_images/" + std::to_string(random.below(1000000)) + "/normal.jpeg\"}";
+        out += ",\"geo\":null,\"coordinates\":null,\"retweet_count\":" + std::to_string(random.below(1000));
+        out += ",\"favorite_count\":" + std::to_string(random.below(1000)) + ",\"entities\":{\"hashtags\":[";
+        for (size_t h = 0, count = random.below(4); h < count; ++h) {
+            if (h > 0) out += ',';
+            out += "{\"text\":" + quoted(random.pick(WORDS)) + ",\"indices\":[" + std::to_string(h * 10) + ","
+                + std::to_string(h * 10 + 8) + "]}";
+        }
+        out += "],\"urls\":[],\"user_mentions\":[";
+        for (size_t m = 0, count = random.below(3); m < count; ++m) {
+            if (m > 0) out += ',';
+            out += "{\"screen_name\":" + quoted(random.pick(WORDS)) + ",\"id\":" + std::to_string(random.below(3000000000ULL))
+                + ",\"indices\":[3," + std::to_string(10 + m) + "]}";
+        }
+        out += "]},\"favorited\":false,\"retweeted\":false,\"lang\":\"ja\"}";
+    }
+    out += "],\"search_metadata\":{\"completed_in\":0.087,\"max_id\":505874924095815681,\"count\":100}}";
+    return out;
+}
+
+// Number-heavy document shaped like canada.json: one polygon of long coordinate rings
+std::string canadaCorpus(size_t scale) {
+    Random random(2);
+    std::string out = "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\",\"properties\":{\"name\":\"Canada\"},"
+                      "\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[";
+    for (size_t ring = 0; ring < 40 * scale; ++ring) {
+        if (ring > 0) out += ',';
+        out += '[';
+        for (size_t point = 0; point < 1400; ++point) {
+            if (point > 0) out += ',';
+            out += '[' + random.decimal(-141, -52, 15) + ',' + random.decimal(41, 83, 15) + ']';
+        }
+        out += ']';
+    }
+    out += "]}}]}";
+    return out;
+}
+
+// Deeply nested document with many keys, shaped like citm_catalog.json
+std::string citmCorpus(size_t scale) {
+    Random random(3);
+    const size_t events = 400 * scale;
+    std::string out = "{\"areaNames\":{";
+    for (size_t i = 0; i < 200; ++i) {
+        if (i > 0) out += ',';
+        out += quoted(std::to_string(205705993 + i)) + ':' + quoted(sentence(random, 2));
+    }
+    out += "},\"events\":{";
+    for (size_t i = 0; i < events; ++i) {
+        if (i > 0) out += ',';
+        const std::string id = std::to_string(138586341 + i * 3);
+        out += quoted(id) + ":{\"description\":null,\"id\":" + id + ",\"logo\":null,\"name\":" + quoted(sentence(random, 3))
+            + ",\"subTopicIds\":[337184269,337184283],\"subjectCode\":null,\"subtitle\":null,\"topicIds\":[324846099,107888604]}";
+    }
+    out += "},\"performances\":[";
+    for (size_t i = 0; i < events * 2; ++i) {
+        if (i > 0) out += ',';
+        out += "{\"eventId\":" + std::to_string(138586341 + (i / 2) * 3) + ",\"id\":" + std::to_string(339887544 + i)
+            + ",\"logo\":null,\"name\":null,\"prices\":[";
+        for (size_t p = 0, count = 1 + random.below(3); p < count; ++p) {
+            if (p > 0) out += ',';
+            out += "{\"amount\":" + std::to_string(10000 + random.below(90000))
+                + ",\"audienceSubCategoryId\":337100890,\"seatCategoryId\":" + std::to_string(338937295 + p) + '}';
+        }
+        out += "],\"seatCategories\":[{\"areas\":[";
+        for (size_t a = 0, count = 1 + random.below(4); a < count; ++a) {
+            if (a > 0) out += ',';
+            out += "{\"areaId\":" + std::to_string(205705993 + random.below(200)) + ",\"blockIds\":[]}";
+        }
+        out += "],\"seatCategoryId\":338937295}],\"seatMapImage\":null,\"start\":" + std::to_string(1372701600000ULL + i * 86400000ULL)
+            + ",\"venueCode\":\"PLEYEL_PLEYEL\",\"venue\":{\"hall\":{\"level\":{\"section\":{\"row\":{\"seat\":{\"number\":"
+            + std::to_string(random.below(40)) + ",\"accessible\":" + (random.chance(10) ? "true" : "false") + "}}}}}}}";
+    }
+    out += "]}";
+    return out;
+}
+
+// Array of strings where most characters need escaping or unescaping
+std::string stringsCorpus(size_t scale) {
+    Random random(4);
+    const std::vector<std::string> pieces = {
+        "plain text", "\\n", "\\t", "\\\"quoted\\\"", "back\\\\slash", "\\/", "\\u00e9", "\\u4e2d\\u6587",
+        "\\ud83d\\ude00", "\\r\\n", "\\b\\f", "caf\\u00e9", "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e", "emoji \xf0\x9f\x9a\x80"
+    };
+    std::string out = "[";
+    for (size_t i = 0; i < 12000 * scale; ++i) {
+        if (i > 0) out += ',';
+        out += '"';
+        for (size_t p = 0, count = 2 + random.below(10); p < count; ++p) out += random.pick(pieces);
+        out += '"';
+    }
+    out += ']';
+    return out;
+}
+
+// JSON Lines log records
+std::string ndjsonCorpus(size_t scale) {
+    Random random(5);
+    const std::vector<std::string> levels = {"debug", "info", "info", "info", "warn", "error"};
+    std::string out;
+    for (size_t i = 0; i < 8000 * scale; ++i) {
+        out += "{\"ts\":" + std::to_string(1700000000000ULL + i * 37) + ",\"level\":" + quoted(random.pick(levels))
+            + ",\"msg\":" + quoted(sentence(random, 3 + random.below(8))) + ",\"user\":{\"id\":" + std::to_string(random.below(1000000))
+            + ",\"name\":" + quoted(random.pick(WORDS)) + "},\"tags\":[" + quoted(random.pick(WORDS)) + ',' + quoted(random.pick(WORDS))
+            + "],\"latency_ms\":" + random.decimal(0, 500, 3) + ",\"ok\":" + (random.chance(95) ? "true" : "false") + "}\n";
+    }
+    return out;
+}
+
+// ---- Measurement ----
+
+struct Options {
+    size_t scale = 1;
+    double minTime = 0.5; // seconds per operation
+    std::string filter;
+    std::string label;
+    bool table = false;
+    std::string dumpDir;
+};
+
+struct Result {
+    std::string corpus;
+    std::string op;
+    size_t bytes = 0;  // JSON text read or written by one iteration
+    size_t values = 0; // values in the document
+    size_t iterations = 0;
+    double best = 0;   // seconds
+    double median = 0; // seconds
+    double allocations = 0; // per iteration
+};
+
+// Results of timed work are folded into this so the compiler cannot drop the work
+volatile size_t sink = 0;
+
+using Clock = std::chrono::steady_clock;
+
+Result measure(const Options& options, const std::string& corpus, const std::string& op,
+               size_t bytes, size_t values, const std::function<size_t()>& work) {
+    sink = sink + work(); // warm up caches and lazily built tables
+
+    std::vector<double> times;
+    times.reserve(10000);
+    double total = 0;
+    const size_t allocationsBefore = allocationCount.load();
+    while ((total < options.minTime || times.size() < 3) && times.size() < 10000) {
+        const Clock::time_point start = Clock::now();
+        sink = sink + work();
+        const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        times.push_back(elapsed);
+        total += elapsed;
+    }
+    const size_t allocations = allocationCount.load() - allocationsBefore;
+
+    Result result{corpus, op, bytes, values, times.size(), 0, 0, 0};
+    std::sort(times.begin(), times.end());
+    result.best = times.front();
+    result.median = times[times.size() / 2];
+    result.allocations = static_cast<double>(allocations) / static_cast<double>(times.size());
+    return result;
+}
+
+size_t countValues(const Json& value) {
+    size_t count = 1;
+    if (value.isArray()) {
+        for (const Json& element : value.asArray()) count += countValues(element);
+    } else if (value.isObject()) {
+        for (const auto& member : value.asObject()) count += countValues(member.second);
+    }
+    return count;
+}
+
+// Reads every value once, the way an application walking the whole document would
+size_t visit(const Json& value) {
+    if (value.isArray()) {
+        size_t sum = 0;
+        for (const Json& element : value.asArray()) sum += visit(element);
+        return sum;
+    }
+    if (value.isObject()) {
+        size_t sum = 0;
+        for (const auto& member : value.asObject()) sum += member.first.size() + visit(member.second);
+        return sum;
+    }
+    if (value.isString()) return value.asString().size();
+    if (value.isNumber()) return static_cast<size_t>(value.asNumber() != 0);
+    if (value.isBoolean()) return value.asBoolean() ? 1 : 0;
+    return 0;
+}
+
+void report(const Options& options, const Result& result) {
+    const double mbPerSecond = static_cast<double>(result.bytes) / result.best / 1e6;
+    const double nsPerValue = result.best * 1e9 / static_cast<double>(result.values);
+    if (options.table) {
+        std::printf("%-8s %-16s %10.1f MB/s %9.2f ns/value %12.1f allocs %7zu iters\n", result.corpus.c_str(),
+                    result.op.c_str(), mbPerSecond, nsPerValue, result.allocations, result.iterations);
+        return;
+    }
+
+    Json row = Json::object();
+    if (!options.label.empty()) row["label"] = options.label;
+    row["corpus"] = result.corpus;
+    row["op"] = result.op;
+    row["scale"] = options.scale;
+    row["bytes"] = result.bytes;
+    row["values"] = result.values;
+    row["iterations"] = result.iterations;
+    row["best_s"] = result.best;
+    row["median_s"] = result.median;
+    row["mb_per_s"] = mbPerSecond;
+    row["ns_per_value"] = nsPerValue;
+    row["allocations"] = result.allocations;
+    std::cout << row.serialize() << std::endl;
+}
+
+bool selected(const Options& options, const std::string& corpus, const std::string& op) {
+    return options.filter.empty() || (corpus + "/" + op).find(options.filter) != std::string::npos;
+}
+
+void benchDocument(const Options& options, const std::string& corpus, const std::string& text) {
+    const Json document = JsonParser(text).parse();
+    const size_t values = countValues(document);
+    const std::string compact = document.serialize();
+    const std::string pretty = document.serialize(4);
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / ("jibby_bench_" + corpus + ".json");
+
+    struct Op {
+        const char* name;
+        size_t bytes;
+        std::function<size_t()> work;
+    };
+    const std::vector<Op> ops = {
+        {"parse", text.size(), [&] { return JsonParser(text).parse().isObject() ? 1 : 0; }},
+        {"push", text.size(), [&] {
+            // As received from a socket, in 16 KB pieces
+            jibby::JsonPushParser parser;
+            for (size_t pos = 0; pos < text.size(); pos += 16 * 1024) {
+                parser.feed(text.data() + pos, std::min<size_t>(16 * 1024, text.size() - pos));
+            }
+            parser.finish();
+            return parser.result().isObject() ? 1 : 0;
+        }},
+        {"serialize", compact.size(), [&] { return document.serialize().size(); }},
+        {"serialize_pretty", pretty.size(), [&] { return document.serialize(4).size(); }},
+        {"save", compact.size(), [&] { document.save(path.string()); return size_t(1); }},
+        {"load", compact.size(), [&] { return Json::load(path.string()).isArray() ? 1 : 0; }},
+        {"access", text.size(), [&] { return visit(document); }},
+    };
+
+    document.save(path.string());
+    for (const Op& op : ops) {
+        if (selected(options, corpus, op.name)) report(options, measure(options, corpus, op.name, op.bytes, values, op.work));
+    }
+    std::filesystem::remove(path);
+}
+
+void benchLines(const Options& options, const std::string& corpus, const std::string& text) {
+    size_t values = 0;
+    jibby::JsonLinesReader(text).forEach([&](size_t, Json& record) {
+        values += countValues(record);
+        return true;
+    });
+
+    if (selected(options, corpus, "parse")) {
+        report(options, measure(options, corpus, "parse", text.size(), values, [&] {
+            size_t records = 0;
+            jibby::JsonLinesReader(text).forEach([&](size_t, Json&) { return ++records != 0; });
+            return records;
+        }));
+    }
+    if (selected(options, corpus, "parse_serial")) {
+        // One line at a time on this thread, for comparison with the parallel reader
+        report(options, measure(options, corpus, "parse_serial", text.size(), values, [&] {
+            size_t records = 0;
+            for (size_t begin = 0; begin < text.size();) {
+                const size_t end = text.find('\n', begin);
+                records += JsonParser(text.data() + begin, end - begin).parse().isObject() ? 1 : 0;
+                begin = end + 1;
+            }
+            return records;
+        }));
+    }
+}
+
+void usage() {
+    std::cerr << "usage: jibby_bench [--scale N] [--min-time SECONDS] [--filter CORPUS/OP] [--label TEXT] [--table] [--dump DIR]\n"
+                 "Prints one JSON object per measurement, or an aligned table with --table. --dump writes the\n"
+                 "generated corpora to DIR and exits\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--scale" && hasValue) options.scale = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        else if (arg == "--min-time" && hasValue) options.minTime = std::strtod(argv[++i], nullptr);
+        else if (arg == "--filter" && hasValue) options.filter = argv[++i];
+        else if (arg == "--label" && hasValue) options.label = argv[++i];
+        else if (arg == "--dump" && hasValue) options.dumpDir = argv[++i];
+        else if (arg == "--table") options.table = true;
+        else return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    struct Corpus {
+        const char* name;
+        std::string (*generate)(size_t scale);
+        bool lines;
+    };
+    const std::vector<Corpus> corpora = {
+        {"twitter", twitterCorpus, false},
+        {"canada", canadaCorpus, false},
+        {"citm", citmCorpus, false},
+        {"strings", stringsCorpus, false},
+        {"ndjson", ndjsonCorpus, true},
+    };
+
+    if (!options.dumpDir.empty()) std::filesystem::create_directories(options.dumpDir);
+    for (const Corpus& corpus : corpora) {
+        const std::string text = corpus.generate(options.scale);
+        if (!options.dumpDir.empty()) {
+            const std::filesystem::path path = std::filesystem::path(options.dumpDir) / (std::string(corpus.name) + (corpus.lines ? ".ndjson" : ".json"));
+            std::ofstream(path, std::ios::binary) << text;
+            continue;
+        }
+        if (corpus.lines) benchLines(options, corpus.name, text);
+        else benchDocument(options, corpus.name, text);
+    }
+    return 0;
+}
@@ -1,17 +1,31 @@
 #ifndef JIBBY_JSON_H
 #define JIBBY_JSON_H
 
+#include <cstdint>
 #include <initializer_list>
+#include <type_traits>
+#include <utility>
 #include "json_exception.h"
+#include "json_object.h"
 #include "json_types.h"
 
 namespace jibby {
 
-    // Forward declare the JsonIterator class for compiler processing
-    class JsonIterator;
+    // Forward declare the iterator, range and writer classes for compiler processing
+    template <typename Value> class JsonBasicIterator;
+    template <typename Iterator> class JsonRange;
+    using JsonIterator = JsonBasicIterator<Json>;
+    using JsonConstIterator = JsonBasicIterator<const Json>;
+    class JsonLazyDocument;
+    class JsonPointer;
+    class JsonSnapshot;
+    class JsonWriter;
 
     // Json class
     class Json {
+        friend class JsonWriter;
+        friend class JsonBinaryWriter;
+
         // Enum of Json types. This will allow for proper declaration, identification, navigation, and manipulation later 
         enum class Type {
             Null,
@@ -24,7 +38,7 @@ namespace jibby {
 
         private:
             Type type; // Json type from Type enum
-            variant<std::nullptr_t, bool, double, string, Object, Array> value; // value being held: can be one of any of the declared types in variant<...>
+            variant<std::nullptr_t, bool, double, JsonString, Object, Array, int64_t, uint64_t> value; // value being held: can be one of any of the declared types in variant<...>
 
         public:
             // Constructors: will instantiate the Json object with the proper type
@@ -36,6 +50,20 @@ namespace jibby {
             Json(const char* str);         
             Json(const Object& obj);       
             Json(const Array& arr);        
+            Json(const JsonString& str);
+
+            // Move construction keeps the memory resource the string or container was allocated
+            // from, so a value moved out of a JsonDocument still lives in its arena
+            Json(JsonString&& str);
+            Json(Object&& obj);
+            Json(Array&& arr);
+
+            // Integers are stored exactly: signed types as int64, unsigned types as uint64
+            template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+            Json(T num) : type(Type::Number) {
+                if constexpr (std::is_signed_v<T>) value = static_cast<int64_t>(num);
+                else value = static_cast<uint64_t>(num);
+            }
 
             // Type Checks: verifies type of Json object and returns the boolean of the check against the given type
             bool isNull() const    { return type == Type::Null; }
@@ -45,26 +73,70 @@ namespace jibby {
             bool isObject() const  { return type == Type::Object; }
             bool isArray() const   { return type == Type::Array; }
 
+            // Number representation checks: integers are kept exactly rather than as doubles.
+            // isInt64/isUInt64 are true for any integer that fits the type
+            bool isInteger() const;
+            bool isInt64() const;
+            bool isUInt64() const;
+
             // Access constants
             const Object& asObject() const;
             const Array& asArray() const;
-            const string& asString() const;
+            // The string in place, valid until the value is modified or destroyed. Construct a
+            // std::string from it to keep a copy; asJsonString() gives the string to modify
+            std::string_view asString() const;
             double asNumber() const;
+            int64_t asInt64() const;
+            uint64_t asUInt64() const;
             bool asBoolean() const;           
 
             // Access mutables
             Object& asObject();
             Array& asArray();
-            string& asString();
-            double& asNumber();
+            double& asNumber(); // integers are converted to double storage first
             bool& asBoolean();
 
+            // The string as stored, allocated from the value's memory resource (see JsonDocument),
+            // to read without a copy or to modify. Throws like asString()
+            const JsonString& asJsonString() const;
+            JsonString& asJsonString();
+
+            // Move the string or container out, leaving this value null. Throw like asObject() etc.
+            JsonString takeString();
+            Object takeObject();
+            Array takeArray();
+
+            // Construct an array element, or an object member if key is not already present, in
+            // place from args. Return the element, or the member's (possibly existing) value
+            template <typename... Args>
+            Json& emplace_back(Args&&... args) { return asArray().emplace_back(std::forward<Args>(args)...); }
+            template <typename... Args>
+            Json& emplace(std::string_view key, Args&&... args) {
+                return asObject().try_emplace(key, std::forward<Args>(args)...).first->second;
+            }
+
             // Iterators for mapped objects and arrays using [] 
-            Json& operator[](const string& key);
+            Json& operator[](std::string_view key);
             Json& operator[](size_t index);
-            const Json& operator[](const string& key) const;
+            const Json& operator[](std::string_view key) const;
             const Json& operator[](size_t index) const;
 
+            // Non-throwing lookups: the member, element or value a pointer refers to, or nullptr
+            // if there is none or this is not an object or array. A JsonKey's stored hash is reused
+            Json* find(std::string_view key);
+            Json* find(const JsonKey& key);
+            Json* find(size_t index);
+            Json* find(const JsonPointer& pointer);
+            const Json* find(std::string_view key) const;
+            const Json* find(const JsonKey& key) const;
+            const Json* find(size_t index) const;
+            const Json* find(const JsonPointer& pointer) const;
+            bool contains(std::string_view key) const { return find(key) != nullptr; }
+
+            // Value a JSON Pointer refers to, throwing JsonException if there is none
+            Json& at(const JsonPointer& pointer);
+            const Json& at(const JsonPointer& pointer) const;
+
 
             // Assignments 
             Json& operator=(const string& str);     
@@ -76,32 +148,63 @@ namespace jibby {
             template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>>
             Json& operator=(T num) {
                 type = Type::Number;
-                value = static_cast<double>(num);
+                if constexpr (std::is_floating_point_v<T>) value = static_cast<double>(num);
+                else if constexpr (std::is_signed_v<T>) value = static_cast<int64_t>(num);
+                else value = static_cast<uint64_t>(num);
                 return *this;
             }          
 
             // Get the Json type of the object
             Type getType() const { return type; }
 
-            // Object Iteration: get the beginning and end of the map/array
+            // Object Iteration: get the beginning and end of the map/array. Each step yields a
+            // (key, value) pair, with an empty key for array elements (see json_iterator.h)
             JsonIterator begin();
             JsonIterator end();
-            JsonIterator begin() const;
-            JsonIterator end() const;
+            JsonConstIterator begin() const;
+            JsonConstIterator end() const;
+
+            // Typed ranges, throwing like asObject() and asArray(). Members yield (key, value)
+            // pairs; elements are the Json values themselves, for standard algorithms
+            JsonRange<JsonIterator> members();
+            JsonRange<JsonConstIterator> members() const;
+            JsonRange<Array::iterator> elements();
+            JsonRange<Array::const_iterator> elements() const;
 
             // Factory Helpers
             static Json object();
             static Json array();
+            static Json object(std::pmr::memory_resource* resource);
+            static Json array(std::pmr::memory_resource* resource);
 
             // Serialize the data
             string serialize(int indent = 0, int depth = 0) const;
 
-            // File I/O for .json files 
+            // Encode as MessagePack or CBOR, and decode a buffer holding exactly one such value.
+            // See JsonBinaryWriter and JsonBinaryReader for streams and sequences of values
+            string toBinary(JsonBinaryFormat format = JsonBinaryFormat::MessagePack) const;
+            static Json fromBinary(std::string_view bytes, JsonBinaryFormat format = JsonBinaryFormat::MessagePack);
+
+            // File I/O for .json files. load() is JsonIO::read(), which memory-maps all but small
+            // files: one truncated while it is loaded can raise SIGBUS
             static Json load(const string& filepath);
+            // Map a file as a JsonLazyDocument (json_lazy.h), decoding only the values read
+            static JsonLazyDocument loadLazy(const string& filepath);
             void save(const string& filepath, bool pretty = false) const;
+            // Binary snapshot files (json_snapshot.h), mapped and read in place rather than parsed
+            static JsonSnapshot loadSnapshot(const string& filepath);
+            void saveSnapshot(const string& filepath) const;
 
         };
 
+    template <typename... Args>
+    std::pair<JsonObject::iterator, bool> JsonObject::try_emplace(std::string_view key, Args&&... args) {
+        const iterator existing = find(key);
+        if (existing != end()) return {existing, false};
+        append(JsonKey(key, resource()), Json(std::forward<Args>(args)...));
+        return {end() - 1, true};
+    }
+
 }
 
 // 
@@ -0,0 +1,125 @@
+#ifndef JIBBY_JSON_BINARY_H
+#define JIBBY_JSON_BINARY_H
+
+#include "json.h"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string_view>
+
+namespace jibby {
+
+    // Binary encoder for MessagePack or CBOR (RFC 8949), writing to the same kinds of sink as
+    // JsonWriter. Integers keep their exact int64/uint64 value, doubles are written as 32-bit
+    // floats when that loses nothing, and strings are copied without escaping
+    class JsonBinaryWriter {
+        public:
+            // Stream output is staged in chunks of this many bytes
+            static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+            // Append to a caller-owned string
+            JsonBinaryWriter(string& out, JsonBinaryFormat format);
+
+            // Write to a stream, buffered
+            JsonBinaryWriter(std::ostream& out, JsonBinaryFormat format);
+
+            JsonBinaryWriter(const JsonBinaryWriter&) = delete;
+            JsonBinaryWriter& operator=(const JsonBinaryWriter&) = delete;
+
+            // Flushes any staged stream output
+            ~JsonBinaryWriter();
+
+            // Encode one value. Values written one after another can be read back in turn by
+            // JsonBinaryReader. Stream output reaches the stream a chunk at a time, the rest
+            // on flush() or destruction
+            void write(const Json& value);
+
+            // Push staged output to the stream sink
+            void flush();
+
+        private:
+            string* target;
+            string staging;
+            std::ostream* stream = nullptr;
+            JsonBinaryFormat format;
+
+            void append(const void* data, size_t length) { target->append(static_cast<const char*>(data), length); }
+            void append(uint8_t byte) { target->push_back(static_cast<char>(byte)); }
+            void appendBigEndian(uint64_t value, size_t bytes);
+
+            void writeMessagePack(const Json& value);
+            void writeMessagePackUnsigned(uint64_t value);
+            void writeMessagePackSigned(int64_t value);
+            void writeMessagePackDouble(double value);
+            // Header of a string, array or map: the fix form below fixLimit, then the 8-bit form
+            // (strings only; 0 if none), the 16-bit form and the 32-bit form that follows it
+            void writeMessagePackLength(size_t length, uint8_t fix, size_t fixLimit, uint8_t wide8, uint8_t wide16);
+
+            void writeCbor(const Json& value);
+            void writeCborHead(uint8_t major, uint64_t value);
+            void writeCborDouble(double value);
+    };
+
+    // Binary decoder for MessagePack or CBOR, building Json values. Types Json cannot hold are
+    // mapped onto the nearest one: byte strings become strings, CBOR undefined becomes null,
+    // tags are dropped in favour of the value they wrap, and integers beyond 64 bits become
+    // doubles. Map keys must be strings. Anything else malformed throws JsonException
+    class JsonBinaryReader {
+        public:
+            // Arrays and maps nested deeper than this are rejected rather than risk the stack
+            static constexpr size_t MAX_DEPTH = 512;
+
+            // Stream input is read in chunks of this many bytes
+            static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+            // Decode from a caller-owned buffer
+            JsonBinaryReader(std::string_view bytes, JsonBinaryFormat format);
+
+            // Decode from a stream, read in chunks as needed
+            JsonBinaryReader(std::istream& in, JsonBinaryFormat format);
+
+            JsonBinaryReader(const JsonBinaryReader&) = delete;
+            JsonBinaryReader& operator=(const JsonBinaryReader&) = delete;
+
+            // Decode the next value
+            Json read();
+
+            // True once every byte of the input has been decoded. Throws JsonException if the
+            // stream fails
+            bool atEnd();
+
+            // Bytes decoded so far
+            size_t offset() const { return base + pos; }
+
+        private:
+            std::string_view input;
+            size_t pos = 0;
+            std::istream* stream = nullptr;
+            string buffer;    // stream input not yet decoded
+            size_t base = 0;  // stream offset of input[0]
+            JsonBinaryFormat format;
+            size_t depth = 0; // of the array or map being read
+
+            void need(size_t count);
+            bool fill(size_t count);
+            uint8_t byte();
+            uint64_t bigEndian(size_t bytes);
+            std::string_view bytes(size_t count);
+            [[noreturn]] void fail(const string& msg) const;
+            size_t plausible(size_t count) const;
+
+            Json readMessagePack();
+            Json readMessagePackString(size_t length);
+            Json readMessagePackArray(size_t length);
+            Json readMessagePackMap(size_t length);
+
+            Json readCbor();
+            uint64_t readCborArgument(uint8_t info);
+            Json readCborString(uint8_t major, uint8_t info);
+            Json readCborArray(uint8_t info);
+            Json readCborMap(uint8_t info);
+    };
+
+}
+
+#endif
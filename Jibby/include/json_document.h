@@ -0,0 +1,79 @@
+#ifndef JIBBY_JSON_DOCUMENT_H
+#define JIBBY_JSON_DOCUMENT_H
+
+#include "json.h"
+#include "json_key_pool.h"
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+
+namespace jibby {
+
+    // A parsed Json tree whose nodes, strings and containers are all allocated from one monotonic
+    // arena owned by the document. Nothing is freed node by node: clearing the document hands the
+    // arena back in one piece, and the next parse reuses it. Object keys are interned, so records
+    // repeating the same keys share one copy of each. The usual Json API works on root();
+    // copying a value out of the document gives an ordinary heap-allocated Json.
+    //
+    // Moving a value out does not: a moved string or container keeps the arena it was
+    // allocated from, and dangles once the document is cleared, reparsed or destroyed. Copy
+    // anything that must outlive the document
+    class JsonDocument {
+        public:
+            // Interned keys are kept across parses up to maxKeys; see clear()
+            explicit JsonDocument(size_t initialCapacity = 64 * 1024, size_t maxKeys = 16 * 1024);
+
+            JsonDocument(const JsonDocument&) = delete;
+            JsonDocument& operator=(const JsonDocument&) = delete;
+
+            // Clear the document, then parse jsonText into it
+            Json& parse(std::string_view jsonText);
+
+            // Copy values out of root() to keep them past the next clear(); see above
+            Json& root() { return rootValue; }
+            const Json& root() const { return rootValue; }
+
+            // Release every node at once. The arena keeps a block as large as the biggest
+            // document seen so far, and interned keys are kept, so reparsing similar input does
+            // not go back to the heap. Keys live outside the arena, so documents keyed by ids or
+            // timestamps would collect them without bound: past maxKeys they are all forgotten
+            // here, and the next parse interns afresh the keys it meets
+            void clear();
+
+            // Clear the document and forget every interned key, whatever their number
+            void clearKeys();
+
+            // Arena the document allocates from, e.g. for Json::object(resource) when building by hand
+            std::pmr::memory_resource* resource();
+
+            // Arena memory held: the reusable block plus any overflow requested since the last clear()
+            size_t arenaSize() const;
+
+            // Distinct object keys interned by the document's parses
+            size_t keyCount() const { return keys.size(); }
+
+        private:
+            // Counts what the arena requests beyond its initial block
+            class CountingResource : public std::pmr::memory_resource {
+                public:
+                    size_t allocated = 0;
+
+                private:
+                    void* do_allocate(size_t bytes, size_t alignment) override;
+                    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+                    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+            };
+
+            std::unique_ptr<std::byte[]> block;
+            size_t blockSize = 0;
+            CountingResource upstream;
+            std::optional<std::pmr::monotonic_buffer_resource> arena;
+            JsonKeyPool keys; // outside the arena, like block, so it survives clear()
+            size_t maxKeys;
+            Json rootValue; // declared last so it is destroyed before the arena
+    };
+
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef JIBBY_JSON_DOM_BUILDER_H
+#define JIBBY_JSON_DOM_BUILDER_H
+
+#include "json.h"
+#include "json_handler.h"
+#include "json_key_pool.h"
+
+namespace jibby {
+
+    // Handler that assembles the events into a Json tree; what JsonParser::parse() runs on
+    class JsonDomBuilder final : public JsonHandler {
+        public:
+            // Strings and containers are allocated from resource. Object keys are interned in
+            // keys if given, which must then outlive the result
+            explicit JsonDomBuilder(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                                    JsonKeyPool* keys = nullptr);
+
+            Action startObject() override;
+            Action key(std::string_view name) override;
+            Action endObject() override;
+            Action startArray() override;
+            Action endArray() override;
+            Action string(std::string_view value) override;
+            Action boolean(bool value) override;
+            Action null() override;
+            Action number(double value) override;
+            Action int64(int64_t value) override;
+            Action uint64(uint64_t value) override;
+
+            // The value built so far, moved out; the builder can then be reused
+            Json result();
+
+        private:
+            std::pmr::memory_resource* resource;
+            JsonKeyPool* keys;
+            // Values are stacked until their container ends, then moved into it in one go, so
+            // every array and object is allocated once at its final size
+            vector<Json> values;
+            vector<JsonKey> names;  // keys of the members on the value stack
+            vector<size_t> starts;  // value stack depth where each open container began
+    };
+
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef JIBBY_JSON_HANDLER_H
+#define JIBBY_JSON_HANDLER_H
+
+#include <cstdint>
+#include <string_view>
+
+namespace jibby {
+
+    // Receives the events of JsonParser::parse(JsonHandler&) as the input is read, without a Json
+    // tree being built. Each event returns what the parser should do next. Every event defaults
+    // to Continue, so a handler only overrides the ones it needs. String views passed to events
+    // are only valid during the call
+    class JsonHandler {
+        public:
+            enum class Action {
+                Continue,
+                Skip,    // from startObject/startArray: skip the container, without its end event.
+                         // From key: skip the member's value; from element: skip the element.
+                         // Same as Continue elsewhere
+                SkipUnchecked, // as Skip, but a skipped object or array is only matched bracket
+                               // to bracket, without its contents being read or validated
+                Stop     // end the parse here
+            };
+
+            virtual ~JsonHandler() = default;
+
+            virtual Action startObject() { return Action::Continue; }
+            virtual Action key(std::string_view name) { (void)name; return Action::Continue; }
+            virtual Action endObject() { return Action::Continue; }
+
+            virtual Action startArray() { return Action::Continue; }
+            // Before each array element, as key() is before each member's value, so an element
+            // can be skipped before it is decoded
+            virtual Action element() { return Action::Continue; }
+            virtual Action endArray() { return Action::Continue; }
+
+            virtual Action string(std::string_view value) { (void)value; return Action::Continue; }
+            virtual Action boolean(bool value) { (void)value; return Action::Continue; }
+            virtual Action null() { return Action::Continue; }
+
+            // Numbers arrive as int64 if they are integers in its range, then uint64, then double.
+            // The integer events fall back to number() unless overridden
+            virtual Action number(double value) { (void)value; return Action::Continue; }
+            virtual Action int64(int64_t value) { return number(static_cast<double>(value)); }
+            virtual Action uint64(uint64_t value) { return number(static_cast<double>(value)); }
+    };
+
+}
+
+#endif
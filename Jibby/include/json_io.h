@@ -2,15 +2,92 @@
 #define JIBBY_IO_H
 
 #include "json.h"
+#include "json_lines_reader.h"
+#include "json_worker_pool.h"
+#include <exception>
+#include <functional>
+#include <future>
+#include <istream>
 #include <string>
 
 namespace jibby {
 
+    // One file read by JsonIO::readMany(): its value, or what reading or parsing it threw
+    struct JsonFileResult {
+        Json value;
+        std::exception_ptr error;
+
+        bool ok() const { return error == nullptr; }
+
+        // The value, or the file's error rethrown
+        Json& get() {
+            if (error) std::rethrow_exception(error);
+            return value;
+        }
+    };
+
+    struct JsonReadOptions {
+        static constexpr size_t MAP_THRESHOLD = 256 * 1024;
+
+        // Threads to read and parse on, which must outlive the call. If null, the call starts
+        // its own, one per hardware thread
+        JsonWorkerPool* pool = nullptr;
+        // Files at least this large are memory-mapped, smaller ones read; see JsonMappedFile
+        size_t mapThreshold = MAP_THRESHOLD;
+    };
+
     class JsonIO {
         public:
-            // Read from file
+            // Where files are not memory-mapped, files at least this large are parsed as a stream,
+            // a chunk at a time, rather than read into memory first
+            static constexpr size_t STREAMING_THRESHOLD = 64 * 1024 * 1024;
+
+            // Files read by each readMany() or readManyAsync() task. Files such as configs are small
+            // enough that with one each, handing them to the pool would cost as much as reading them
+            static constexpr size_t FILES_PER_TASK = 8;
+
+            // Receives each file's result and its position in paths. Return false to stop reading
+            using FileCallback = std::function<bool(size_t index, JsonFileResult& result)>;
+
+            // Read from file. Files under JsonReadOptions::MAP_THRESHOLD are read whole; larger ones
+            // are memory-mapped where supported, however large, as by readMapped(). If a mapped
+            // file is truncated while it is parsed, the process may get SIGBUS. Where mapping is
+            // unavailable, files from STREAMING_THRESHOLD up are streamed. Parse from a stream,
+            // read(std::istream&), to stream on any platform or where files can shrink under the
+            // reader
             static Json read(const string& filepath);
 
+            // Read from a memory-mapped file, parsing straight from the mapped bytes. Falls back
+            // to reading the file into memory where mapping is unavailable. The file must not be
+            // truncated while it is parsed; see read()
+            static Json readMapped(const string& filepath);
+
+            // Read from a stream, chunk by chunk, without holding the whole text in memory
+            static Json read(std::istream& in);
+
+            // Read a file of JSON Lines or concatenated values in parallel, memory-mapped where
+            // supported. See JsonLinesReader::forEach()
+            static bool readLines(const string& filepath, const JsonLinesReader::RecordCallback& onRecord,
+                                  JsonLinesReader::Format format = JsonLinesReader::Format::Lines);
+
+            // Read and parse many files at once on a worker pool, each independently. Results
+            // come back in the order of paths, a file that is missing or invalid holding its
+            // error rather than failing the others
+            static vector<JsonFileResult> readMany(const vector<string>& paths, const JsonReadOptions& options = {});
+
+            // As above, handing each result to onFile on the calling thread, in order, as soon as
+            // it and those before it are ready. Only a few files per thread are read ahead of the
+            // one delivered. Returns false if onFile stopped the read
+            static bool readMany(const vector<string>& paths, const FileCallback& onFile,
+                                 const JsonReadOptions& options = {});
+
+            // Queue every file on options.pool, which must outlive the futures' tasks, and return at
+            // once. Each future holds the file's value or rethrows its error. As the tasks outlive
+            // the call, with no pool given they run on one shared by such calls, which lasts until
+            // the program exits
+            static vector<std::future<Json>> readManyAsync(const vector<string>& paths,
+                                                           const JsonReadOptions& options = {});
+
             // Write to file
             static void write(const Json& json, const string& filepath, bool pretty=false);
 
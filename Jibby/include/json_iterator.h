@@ -1,41 +1,107 @@
 #ifndef JIBBY_JSON_ITERATOR_H
 #define JIBBY_JSON_ITERATOR_H
 
-#include "json_types.h"
+#include "json_object.h"
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 namespace jibby{
 
-    class JsonIterator {
+    // Iterator over the members of an object or the elements of an array, yielding
+    // (key, value) pairs. Keys are views of the stored keys, valid while the member is, and
+    // empty for array elements; nothing is copied or allocated per step. Value is Json or
+    // const Json.
+    //
+    // Both kinds of container are contiguous, so steps, distances and comparisons are
+    // constant-time. But each pair is built on dereference rather than referred to, which the
+    // standard allows only of input iterators, so that is the category advertised: algorithms
+    // that reorder, such as std::sort, need Json::elements() or the object itself
+    template <typename Value>
+    class JsonBasicIterator {
+        using Member = std::conditional_t<std::is_const_v<Value>, const JsonObject::Member, JsonObject::Member>;
+
         public:
-            // Typedefs fro convenience
-            using ObjIter    = Object::iterator;
-            using ArrIter    = Array::iterator;
-            using CObjIter   = Object::const_iterator;
-            using CArrIter   = Array::const_iterator;
+            using iterator_category = std::input_iterator_tag;
+            using value_type        = std::pair<std::string_view, Value&>;
+            using difference_type   = std::ptrdiff_t;
+            using reference         = value_type; // a proxy, built on dereference
+
+            // What operator-> points at: the pair, held for the length of the expression
+            struct pointer {
+                value_type entry;
+                const value_type* operator->() const { return &entry; }
+            };
+
+            JsonBasicIterator() = default;
+            explicit JsonBasicIterator(Member* member) : member(member) {}
+            explicit JsonBasicIterator(Value* element) : element(element) {}
+
+            // A mutable iterator converts to a const one
+            template <typename Other, typename = std::enable_if_t<std::is_const_v<Value> && !std::is_const_v<Other>>>
+            JsonBasicIterator(const JsonBasicIterator<Other>& other) : member(other.member), element(other.element) {}
+
+            std::string_view key() const { return member ? std::string_view(member->first) : std::string_view(); }
+            Value& value() const { return member ? member->second : *element; }
 
-            // Variant can hold any one of the typedefs
-            using IterVariant = std::variant<ObjIter, ArrIter, CObjIter, CArrIter>;
+            reference operator*() const { return {key(), value()}; }
+            pointer operator->() const { return {**this}; }
+            reference operator[](difference_type n) const { return *(*this + n); }
 
-            // Constructor overloads for each kind
-            JsonIterator(ObjIter it);
-            JsonIterator(ArrIter it);
-            JsonIterator(CObjIter it);
-            JsonIterator(CArrIter it);
+            JsonBasicIterator& operator+=(difference_type n) {
+                if (member) member += n;
+                else element += n;
+                return *this;
+            }
+            JsonBasicIterator& operator-=(difference_type n) { return *this += -n; }
+            JsonBasicIterator& operator++() { return *this += 1; }
+            JsonBasicIterator& operator--() { return *this += -1; }
+            JsonBasicIterator operator++(int) { JsonBasicIterator previous = *this; ++*this; return previous; }
+            JsonBasicIterator operator--(int) { JsonBasicIterator previous = *this; --*this; return previous; }
 
-            // Increment
-            JsonIterator& operator++();
+            friend JsonBasicIterator operator+(JsonBasicIterator it, difference_type n) { return it += n; }
+            friend JsonBasicIterator operator+(difference_type n, JsonBasicIterator it) { return it += n; }
+            friend JsonBasicIterator operator-(JsonBasicIterator it, difference_type n) { return it -= n; }
+            friend difference_type operator-(const JsonBasicIterator& a, const JsonBasicIterator& b) {
+                return a.member ? a.member - b.member : a.element - b.element;
+            }
 
-            // Inequality
-            bool operator!=(const JsonIterator& other) const;
+            // Iterators into different containers do not compare meaningfully, as with std iterators
+            friend bool operator==(const JsonBasicIterator& a, const JsonBasicIterator& b) {
+                return a.member == b.member && a.element == b.element;
+            }
+            friend bool operator!=(const JsonBasicIterator& a, const JsonBasicIterator& b) { return !(a == b); }
+            friend bool operator<(const JsonBasicIterator& a, const JsonBasicIterator& b) { return b - a > 0; }
+            friend bool operator>(const JsonBasicIterator& a, const JsonBasicIterator& b) { return b < a; }
+            friend bool operator<=(const JsonBasicIterator& a, const JsonBasicIterator& b) { return !(b < a); }
+            friend bool operator>=(const JsonBasicIterator& a, const JsonBasicIterator& b) { return !(a < b); }
 
-            // Dereference for mutable iteration
-            std::pair<string, Json&> operator*();
+        private:
+            template <typename> friend class JsonBasicIterator;
+
+            // At most one is set; both are null in a default-constructed iterator and for an
+            // empty container, which has nothing to dereference
+            Member* member = nullptr;
+            Value* element = nullptr;
+    };
+
+    // A begin/end pair, as returned by Json::members() and Json::elements()
+    template <typename Iterator>
+    class JsonRange {
+        public:
+            JsonRange(Iterator first, Iterator last) : first(first), last(last) {}
 
-            // Dereference for const iteration
-            std::pair<string, const Json&> operator*() const;
+            Iterator begin() const { return first; }
+            Iterator end() const { return last; }
+            size_t size() const { return static_cast<size_t>(last - first); }
+            bool empty() const { return first == last; }
+            decltype(auto) operator[](size_t index) const { return first[static_cast<std::ptrdiff_t>(index)]; }
 
         private:
-            IterVariant iter;
+            Iterator first;
+            Iterator last;
     };
 
 }
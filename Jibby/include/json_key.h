@@ -0,0 +1,84 @@
+#ifndef JIBBY_JSON_KEY_H
+#define JIBBY_JSON_KEY_H
+
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+
+namespace jibby {
+
+    // Object member key. A key either owns a copy of its text or refers to text interned in a
+    // JsonKeyPool, which must then outlive it. Owned keys of up to INLINE_CAPACITY bytes, which is
+    // most of them, are stored in the key itself and never allocate; longer ones are allocated
+    // from the key's memory resource. Inline text moves with the key, so views of it last only
+    // as long as the key stays put. The text is not null-terminated. The hash used by JsonObject
+    // is computed once, when the key is made
+    class JsonKey {
+        public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+            // Longest owned key stored without allocating
+            static constexpr size_t INLINE_CAPACITY = 16;
+
+            JsonKey() noexcept : JsonKey(allocator_type()) {}
+            explicit JsonKey(const allocator_type& alloc) noexcept;
+
+            // Owned copy of text
+            explicit JsonKey(std::string_view text, const allocator_type& alloc = allocator_type());
+
+            // A plain copy refers to the same pool entry if other is interned. Containers copy
+            // through the allocator-extended form, which always makes an owned copy, so copying
+            // a Json gives keys independent of any pool
+            JsonKey(const JsonKey& other);
+            JsonKey(const JsonKey& other, const allocator_type& alloc);
+
+            // Moving hands over the text if both keys use the same resource, or if it is interned
+            JsonKey(JsonKey&& other) noexcept;
+            JsonKey(JsonKey&& other, const allocator_type& alloc);
+
+            JsonKey& operator=(const JsonKey& other);
+            JsonKey& operator=(JsonKey&& other);
+
+            ~JsonKey();
+
+            // Key referring to text stored elsewhere, for JsonKeyPool
+            static JsonKey interned(std::string_view text, uint32_t hash) noexcept;
+
+            const char* data() const { return text; }
+            size_t size() const { return length; }
+            bool empty() const { return length == 0; }
+            uint32_t hash() const { return keyHash; }
+            bool isInterned() const { return pooled; }
+            allocator_type get_allocator() const { return allocator_type(resource); }
+
+            operator std::string_view() const { return std::string_view(text, length); }
+
+            // Keys from the same pool share their text, so equal keys usually compare by address
+            friend bool operator==(const JsonKey& key, std::string_view other) {
+                return key.length == other.size()
+                    && (key.text == other.data() || std::string_view(key.text, key.length) == other);
+            }
+            friend bool operator==(std::string_view other, const JsonKey& key) { return key == other; }
+            friend bool operator==(const JsonKey& a, const JsonKey& b) { return a == std::string_view(b); }
+            friend bool operator!=(const JsonKey& key, std::string_view other) { return !(key == other); }
+            friend bool operator!=(std::string_view other, const JsonKey& key) { return !(key == other); }
+            friend bool operator!=(const JsonKey& a, const JsonKey& b) { return !(a == b); }
+
+            // Hash of a key's text, stable for the life of the process
+            static uint32_t hashText(std::string_view text);
+
+        private:
+            const char* text;
+            size_t length = 0;
+            uint32_t keyHash = 0;
+            bool pooled = false;
+            std::pmr::memory_resource* resource;
+            char local[INLINE_CAPACITY]; // text of short owned keys
+
+            void assign(std::string_view value);
+            void release();
+    };
+
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef JIBBY_JSON_KEY_POOL_H
+#define JIBBY_JSON_KEY_POOL_H
+
+#include "json_key.h"
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+namespace jibby {
+
+    // Interning table for object keys. Each distinct key text is stored once, and every object
+    // parsed with the pool refers to that copy instead of allocating its own, which pays off for
+    // arrays of records that repeat the same keys. Keys handed out stay valid until clear() or
+    // the pool is destroyed, so the pool must outlive the values parsed with it
+    class JsonKeyPool {
+        public:
+            explicit JsonKeyPool(std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+            JsonKeyPool(const JsonKeyPool&) = delete;
+            JsonKeyPool& operator=(const JsonKeyPool&) = delete;
+
+            // Key for text, adding it to the pool the first time it is seen
+            JsonKey intern(std::string_view text);
+
+            // Number of distinct keys held
+            size_t size() const { return keys.size(); }
+
+            // Forget every key. Values still referring to the pool must be gone by then
+            void clear();
+
+        private:
+            std::pmr::monotonic_buffer_resource storage; // key text
+            std::pmr::vector<JsonKey> keys;             // interned keys in insertion order
+            std::pmr::vector<uint32_t> slots;           // open-addressing index: key position + 1, 0 when empty
+
+            void grow();
+    };
+
+}
+
+#endif
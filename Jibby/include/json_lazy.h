@@ -0,0 +1,140 @@
+#ifndef JIBBY_JSON_LAZY_H
+#define JIBBY_JSON_LAZY_H
+
+#include "json.h"
+#include "json_mapped_file.h"
+#include <deque>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace jibby {
+
+    class JsonLazyDocument;
+
+    // One value of a JsonLazyDocument. A small handle into the text, cheap to copy and valid for
+    // as long as its document. Nothing is decoded until it is asked for, and then only once
+    class JsonLazyValue {
+        public:
+            // Walks the members of an object or the elements of an array, in order. Keys are
+            // empty for array elements
+            class Iterator {
+                public:
+                    std::pair<std::string_view, JsonLazyValue> operator*() const;
+                    Iterator& operator++() { ++position; return *this; }
+                    bool operator!=(const Iterator& other) const { return position != other.position; }
+
+                private:
+                    friend class JsonLazyValue;
+                    const JsonLazyDocument* document;
+                    size_t offset; // of the container
+                    size_t position;
+                    Iterator(const JsonLazyDocument* document, size_t offset, size_t position)
+                        : document(document), offset(offset), position(position) {}
+            };
+
+            // Type checks, read from the first character of the value
+            bool isNull() const    { return first() == 'n'; }
+            bool isBoolean() const { return first() == 't' || first() == 'f'; }
+            bool isNumber() const  { return first() == '-' || (first() >= '0' && first() <= '9'); }
+            bool isString() const  { return first() == '"'; }
+            bool isObject() const  { return first() == '{'; }
+            bool isArray() const   { return first() == '['; }
+
+            // Member count of an object or element count of an array. The first call on a
+            // container finds where each of its children starts and ends, without decoding them
+            size_t size() const;
+            bool contains(std::string_view key) const;
+
+            // Lookups, throwing the same exceptions as Json's. If a key repeats, the last one wins
+            JsonLazyValue operator[](std::string_view key) const;
+            JsonLazyValue operator[](size_t index) const;
+
+            // Scalars, decoded on first access
+            std::string_view asString() const;
+            double asNumber() const;
+            int64_t asInt64() const;
+            uint64_t asUInt64() const;
+            bool asBoolean() const;
+
+            // The whole value as a Json tree, built on first access
+            const Json& json() const;
+
+            // The value's text in the document
+            std::string_view raw() const;
+
+            // Iteration over an object or array (range-for)
+            Iterator begin() const;
+            Iterator end() const;
+
+        private:
+            friend class JsonLazyDocument;
+            const JsonLazyDocument* document;
+            size_t offset; // first character of the value
+            size_t length;
+
+            JsonLazyValue(const JsonLazyDocument* document, size_t offset, size_t length)
+                : document(document), offset(offset), length(length) {}
+
+            char first() const;
+    };
+
+    // A document validated up front but decoded only where it is read. Construction checks the
+    // whole text is valid JSON and notes where every object and array closes, so any subtree can
+    // be stepped over without reading it. Objects, arrays, strings and numbers are materialized
+    // as they are reached through root() and cached. Reading a few fields of a large document
+    // then costs little more than validating it. Not safe for concurrent reads
+    class JsonLazyDocument {
+        public:
+            // Use a caller-owned buffer, which must outlive the document
+            explicit JsonLazyDocument(std::string_view jsonText);
+            explicit JsonLazyDocument(const char* jsonText);
+            // Take over a string, or a file mapping as from Json::loadLazy()
+            explicit JsonLazyDocument(string&& jsonText);
+            explicit JsonLazyDocument(JsonMappedFile&& file);
+
+            // Handles point at the document, so it stays where it was built
+            JsonLazyDocument(const JsonLazyDocument&) = delete;
+            JsonLazyDocument& operator=(const JsonLazyDocument&) = delete;
+
+            JsonLazyValue root() const;
+
+            // Values decoded so far, containers and scalars alike
+            size_t materializedCount() const;
+
+        private:
+            friend class JsonLazyValue;
+
+            // A child of a container: where its text is and, for object members, its key
+            struct Entry {
+                std::string_view key;
+                uint32_t keyHash;
+                size_t offset;
+                size_t length;
+            };
+
+            // What has been worked out about one value, keyed by its offset
+            struct Node {
+                bool indexed = false;
+                vector<Entry> entries;
+                std::optional<Json> value;
+            };
+
+            string owned;
+            std::optional<JsonMappedFile> file;
+            std::string_view text;
+            vector<std::pair<size_t, size_t>> containers; // opening and closing offsets, by opening
+            mutable std::unordered_map<size_t, Node> nodes;
+            mutable std::deque<string> decodedKeys; // keys containing escapes, decoded
+
+            void validate();
+            const vector<Entry>& entries(size_t offset) const;
+            const Json& value(size_t offset, size_t length) const;
+            size_t valueEnd(size_t offset) const;
+            size_t stringEnd(size_t offset) const;
+    };
+
+}
+
+#endif
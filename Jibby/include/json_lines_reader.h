@@ -0,0 +1,70 @@
+#ifndef JIBBY_JSON_LINES_READER_H
+#define JIBBY_JSON_LINES_READER_H
+
+#include "json.h"
+#include "json_exception.h"
+#include "json_scanner.h"
+#include "json_worker_pool.h"
+#include <functional>
+#include <memory>
+#include <string_view>
+
+namespace jibby {
+
+    // Reads a sequence of JSON records: newline-delimited (JSON Lines, NDJSON), values simply
+    // written one after another, or the elements of one large array. Record boundaries are found on the calling thread, then batches
+    // of records are parsed in place on a worker pool while the next boundaries are found.
+    // Records are handed back in input order on the calling thread
+    class JsonLinesReader {
+        public:
+            enum class Format {
+                Lines,        // one value per line, blank lines ignored
+                Concatenated, // values back to back, separated by optional whitespace
+                Elements      // the elements of a top-level array; any other text is one record
+            };
+
+            // Approximate bytes of input parsed per task
+            static constexpr size_t BATCH_SIZE = 256 * 1024;
+
+            // Receives each record and its zero-based position. Return false to stop reading
+            using RecordCallback = std::function<bool(size_t index, Json& record)>;
+            // Receives a record that failed to parse. Return true to skip it and carry on
+            using ErrorCallback = std::function<bool(size_t index, const JsonParseException& error)>;
+
+            // text must outlive the reader. So must pool, if given; otherwise the reader starts
+            // its own threads, one per hardware thread
+            explicit JsonLinesReader(std::string_view text, Format format = Format::Lines,
+                                     JsonWorkerPool* pool = nullptr);
+
+            // Deliver every record to onRecord. The first record that fails to parse is thrown
+            // as a JsonParseException, once the records before it have been delivered. Line and
+            // column refer to the whole text. Returns false if onRecord stopped the read
+            bool forEach(const RecordCallback& onRecord);
+            bool forEach(const RecordCallback& onRecord, const ErrorCallback& onError);
+
+        private:
+            std::string_view text;
+            Format format;
+            JsonWorkerPool* pool;
+            std::unique_ptr<JsonWorkerPool> ownPool;
+
+            // Boundary search state, reset by each forEach()
+            size_t pos = 0;
+            JsonScanner scanner;
+            vector<size_t> index;
+            size_t cursor = 0;
+            bool opened = false;    // past the opening bracket of Elements
+            bool separated = false; // a comma has been seen since then
+            bool finished = false;
+
+            // Offsets of the next record, false once there are none left
+            bool nextRecord(size_t& begin, size_t& end);
+            bool nextLine(size_t& begin, size_t& end);
+            bool nextValue(size_t& begin, size_t& end);
+            bool nextElement(size_t& begin, size_t& end);
+            bool peekIndexed(size_t& offset);
+    };
+
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef JIBBY_JSON_MAPPED_FILE_H
+#define JIBBY_JSON_MAPPED_FILE_H
+
+#include "json_types.h"
+#include <string_view>
+
+namespace jibby {
+
+    // Read-only view of a whole file. On POSIX systems the file is memory-mapped, so parsing
+    // reads the page cache directly instead of a heap copy. Elsewhere, or for files that cannot
+    // be mapped such as pipes, the contents are read into a buffer owned by this object.
+    // Parsing text() with JsonParser::parse(JsonHandler&) hands out views into the mapping for
+    // strings and keys without escapes, which then stay valid for as long as the file does
+    class JsonMappedFile {
+        public:
+            // Regular files smaller than minMappedSize are read into the buffer with plain reads
+            // instead of being mapped: for a small file, setting up and tearing down a mapping
+            // costs more than the copy it saves, and unmapping interrupts every thread of the process
+            explicit JsonMappedFile(const string& filepath, size_t minMappedSize = 0);
+
+            JsonMappedFile(const JsonMappedFile&) = delete;
+            JsonMappedFile& operator=(const JsonMappedFile&) = delete;
+            JsonMappedFile(JsonMappedFile&& other) noexcept;
+            JsonMappedFile& operator=(JsonMappedFile&& other) noexcept;
+
+            ~JsonMappedFile();
+
+            std::string_view text() const { return view; }
+            size_t size() const { return view.size(); }
+
+            // True if text() is the mapping itself rather than a copy
+            bool isMapped() const { return mapping != nullptr; }
+
+            // True if this platform maps files at all
+            static bool supported();
+
+        private:
+            void* mapping = nullptr;
+            size_t mappingSize = 0;
+            string contents; // fallback copy when the file is not mapped
+            std::string_view view;
+
+            void unmap();
+    };
+
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef JIBBY_JSON_NUMBER_H
+#define JIBBY_JSON_NUMBER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace jibby {
+
+    // Decimal decomposition of a JSON number, filled in by the tokenizer while it validates the
+    // number: value = (negative ? -1 : 1) * digits * 10^exponent
+    struct JsonNumber {
+        uint64_t digits = 0;     // up to the first 19 significant digits
+        int64_t exponent = 0;    // decimal exponent applied to digits
+        bool negative = false;
+        bool integer = true;     // no fraction or exponent part
+        bool truncated = false;  // significant digits beyond the 19 kept in digits
+
+        // Maximum number of significant digits kept in digits
+        static constexpr int MAX_DIGITS = 19;
+
+        // Check that text is exactly one JSON number and decompose it into out, in one pass. On
+        // failure, error and offset (within text) say what is wrong and where
+        static bool parse(std::string_view text, JsonNumber& out, const char*& error, size_t& offset);
+
+        // Nearest double, correctly rounded and independent of the C locale. Exact cases are
+        // computed directly; anything else is converted from text, the number's spelling.
+        // Returns false if the number is too large for a double
+        bool toDouble(std::string_view text, double& out) const;
+
+        // Exact integer value, for integers without fraction or exponent that fit the type.
+        // text is only needed for integers with more digits than are kept in digits
+        bool toInt64(int64_t& out) const;
+        bool toUInt64(std::string_view text, uint64_t& out) const;
+
+        // Room needed by formatDouble()
+        static constexpr size_t MAX_DOUBLE_LENGTH = 32;
+
+        // Write the shortest text that parses back to exactly value and return its length.
+        // Integral values keep a ".0" so they read back as doubles. NaN and infinity have no
+        // JSON spelling and are written as null
+        static size_t formatDouble(double value, char* out);
+    };
+
+}
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef JIBBY_JSON_OBJECT_H
+#define JIBBY_JSON_OBJECT_H
+
+#include "json_key.h"
+#include "json_types.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace jibby {
+
+    // Json object storage: key/value members kept contiguously in insertion order, so objects
+    // serialize in the order they were read or built. Small objects are searched linearly
+    // through a packed array of key hashes; past INDEX_THRESHOLD members an open-addressing
+    // index of member positions is built alongside it
+    class JsonObject {
+        public:
+            using Member = std::pair<JsonKey, Json>;
+
+            // Iterator over the members, yielding (key, value) pairs of references built on
+            // dereference. Keys are const, as the index is built from them: a member's key only
+            // changes by erasing it. Steps and distances are constant-time, but as the pairs are
+            // not references the iterator is only an input iterator. Value is Json or const Json
+            template <typename Value>
+            class BasicIterator {
+                using Stored = std::conditional_t<std::is_const_v<Value>, const Member, Member>;
+
+                public:
+                    using iterator_category = std::input_iterator_tag;
+                    using value_type        = std::pair<const JsonKey&, Value&>;
+                    using difference_type   = std::ptrdiff_t;
+                    using reference         = value_type;
+
+                    // What operator-> points at: the pair, held for the length of the expression
+                    struct pointer {
+                        value_type entry;
+                        const value_type* operator->() const { return &entry; }
+                    };
+
+                    BasicIterator() = default;
+
+                    // A mutable iterator converts to a const one
+                    template <typename Other, typename = std::enable_if_t<std::is_const_v<Value> && !std::is_const_v<Other>>>
+                    BasicIterator(const BasicIterator<Other>& other) : member(other.member) {}
+
+                    reference operator*() const { return {member->first, member->second}; }
+                    pointer operator->() const { return {**this}; }
+                    reference operator[](difference_type n) const { return *(*this + n); }
+
+                    BasicIterator& operator+=(difference_type n) { member += n; return *this; }
+                    BasicIterator& operator-=(difference_type n) { member -= n; return *this; }
+                    BasicIterator& operator++() { ++member; return *this; }
+                    BasicIterator& operator--() { --member; return *this; }
+                    BasicIterator operator++(int) { BasicIterator previous = *this; ++member; return previous; }
+                    BasicIterator operator--(int) { BasicIterator previous = *this; --member; return previous; }
+
+                    friend BasicIterator operator+(BasicIterator it, difference_type n) { return it += n; }
+                    friend BasicIterator operator+(difference_type n, BasicIterator it) { return it += n; }
+                    friend BasicIterator operator-(BasicIterator it, difference_type n) { return it -= n; }
+                    friend difference_type operator-(const BasicIterator& a, const BasicIterator& b) { return a.member - b.member; }
+
+                    friend bool operator==(const BasicIterator& a, const BasicIterator& b) { return a.member == b.member; }
+                    friend bool operator!=(const BasicIterator& a, const BasicIterator& b) { return a.member != b.member; }
+                    friend bool operator<(const BasicIterator& a, const BasicIterator& b) { return a.member < b.member; }
+                    friend bool operator>(const BasicIterator& a, const BasicIterator& b) { return a.member > b.member; }
+                    friend bool operator<=(const BasicIterator& a, const BasicIterator& b) { return a.member <= b.member; }
+                    friend bool operator>=(const BasicIterator& a, const BasicIterator& b) { return a.member >= b.member; }
+
+                private:
+                    friend class JsonObject;
+                    template <typename> friend class BasicIterator;
+
+                    explicit BasicIterator(Stored* member) : member(member) {}
+
+                    Stored* member = nullptr;
+            };
+
+            using iterator = BasicIterator<Json>;
+            using const_iterator = BasicIterator<const Json>;
+
+            // Objects with more members than this get a hash index
+            static constexpr size_t INDEX_THRESHOLD = 16;
+
+            JsonObject() = default;
+            explicit JsonObject(std::pmr::memory_resource* resource) : members(resource), lookup(resource) {}
+
+            size_t size() const;
+            bool empty() const;
+            void reserve(size_t count);
+            void clear();
+
+            iterator begin();
+            iterator end();
+            const_iterator begin() const;
+            const_iterator end() const;
+
+            // Member with the given key, or end()
+            iterator find(std::string_view key);
+            const_iterator find(std::string_view key) const;
+            // Same, reusing the hash a key already carries
+            iterator find(const JsonKey& key);
+            const_iterator find(const JsonKey& key) const;
+            size_t count(std::string_view key) const;
+
+            // Member value for key, appending a null member if there is none
+            Json& operator[](std::string_view key);
+
+            // Append a member whose value is constructed from args, unless key is already present,
+            // in which case args are left untouched. The bool is true if a member was appended.
+            // Defined in json.h, where Json is complete
+            template <typename... Args>
+            std::pair<iterator, bool> try_emplace(std::string_view key, Args&&... args);
+
+            // Replace the value of an existing member in place, or append a new one. The bool is
+            // true if a member was appended
+            std::pair<iterator, bool> insert_or_assign(std::string_view key, Json value);
+            std::pair<iterator, bool> insert_or_assign(JsonKey key, Json value);
+
+            // Remove a member, keeping the order of the rest. Returns the number removed
+            size_t erase(std::string_view key);
+            iterator erase(const_iterator pos);
+
+            // Memory resource the members are allocated from
+            std::pmr::memory_resource* resource() const { return members.get_allocator().resource(); }
+
+        private:
+            friend class Json; // for Json's own iterators, which also step over arrays
+
+            std::pmr::vector<Member> members;
+            // Index slots followed by one key hash per member. Slots hold member position + 1,
+            // 0 when empty, and are absent while the object is at or below INDEX_THRESHOLD
+            std::pmr::vector<uint32_t> lookup;
+
+            size_t slotCount() const;
+            size_t position(std::string_view key, uint32_t hash) const;
+            Member& append(JsonKey&& key, Json&& value);
+            iterator at(size_t pos);
+            const_iterator at(size_t pos) const;
+            void reindex(size_t slots);
+    };
+
+}
+
+#endif
@@ -2,32 +2,115 @@
 #define JIBBY_JSON_PARSER_H
 
 #include "json.h"
+#include "json_handler.h"
+#include "json_key_pool.h"
 #include "json_tokenizer.h"
 #include "json_exception.h"
+#include <istream>
 
 namespace jibby {
 
+    class JsonProjection;
+    class JsonWorkerPool;
+
     // class for parsing string of Json object
     class JsonParser {
 
         public:
-            explicit JsonParser(const string& jsonText);
+            // Smallest input parseParallel() splits across threads
+            static constexpr size_t PARALLEL_THRESHOLD = 1024 * 1024;
+
+            // Parse a caller-owned buffer in place. The buffer must outlive the parser
+            explicit JsonParser(std::string_view jsonText);
+            explicit JsonParser(const char* jsonText);
+            JsonParser(const char* data, size_t length);
+
+            // Parse a string handed over to the parser; it is moved in, not copied
+            explicit JsonParser(string&& jsonText);
+
+            // Parse a caller-owned buffer, allocating every string and container of the result
+            // from resource, which must outlive the result
+            JsonParser(std::string_view jsonText, std::pmr::memory_resource* resource);
+
+            // Parse with object keys interned in keys, so repeated keys share one copy. keys must
+            // outlive the result. resource, if given, is used as above for everything else
+            JsonParser(std::string_view jsonText, JsonKeyPool& keys);
+            JsonParser(std::string_view jsonText, std::pmr::memory_resource* resource, JsonKeyPool& keys);
+
+            // Parse streamed input, read chunkSize bytes at a time. Memory is bounded by the chunk
+            // size plus the result, or stays constant with parse(JsonHandler&)
+            explicit JsonParser(std::istream& in, size_t chunkSize = JsonTokenizer::DEFAULT_CHUNK_SIZE);
+            // Same, pulling input from source, e.g. a wrapper around read() on a file descriptor
+            explicit JsonParser(JsonSource source, size_t chunkSize = JsonTokenizer::DEFAULT_CHUNK_SIZE);
+
+            // Parse the single value in document[begin, end), e.g. one record of a larger buffer.
+            // Error lines and columns are those within the whole document
+            JsonParser(std::string_view document, size_t begin, size_t end);
+
+            JsonParser(const JsonParser&) = delete;
+            JsonParser& operator=(const JsonParser&) = delete;
+
+            // Parse the whole input into a Json tree
             Json parse();
 
+            // Parse the whole input, reporting it to handler as events instead of building a tree.
+            // Input is validated the same way. Returns false if the handler stopped the parse, in
+            // which case the rest of the input is not read
+            bool parse(JsonHandler& handler);
+
+            // Parse only the values at the paths of projection, and the objects and arrays leading
+            // to them. Everything else is skipped bracket to bracket, so it is neither decoded nor
+            // allocated, and only checked for matching brackets and closed strings
+            Json parse(const JsonProjection& projection);
+
+            // Parse a top-level array with its elements split across the threads of pool, or of a
+            // pool started for the call if none is given. The result and any error are the same
+            // as parse()'s. Falls back to parse() for other documents, small or streamed input,
+            // and parsers given a memory resource or key pool, which are not shared across threads
+            Json parseParallel(JsonWorkerPool* pool = nullptr);
+
+            // Check the whole input is valid JSON without building or reporting anything.
+            // Strings and numbers are checked but never copied out or converted. If containers is given, it receives
+            // the offsets of the opening and closing bracket of every object and array, in the
+            // order they open
+            void validate(vector<std::pair<size_t, size_t>>* containers = nullptr);
+
+            // Add what the following parse, validate() etc. calls see to stats, which must outlive
+            // them. parseParallel() only counts parses, bytes, allocations and time when it splits
+            // the input. No-op unless built with JIBBY_STATS
+            void collect(JsonParseStats& stats);
+
         private:
+            string owned; // backing storage when the parser owns its input, declared before tokenizer
             JsonTokenizer tokenizer;
             Token current;
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+            JsonKeyPool* keys = nullptr;
+            vector<std::pair<size_t, size_t>>* spans = nullptr; // containers being recorded by validate()
+            JsonParseStats* stats = nullptr;
+            size_t depth = 0; // of the container being parsed, tracked for stats
+
+            class StatsScope;
 
             void advance();
             bool match(TokenType expected);
-            void expect(TokenType expected, const string& errorMsg);
-
-            Json parseValue();
-            Json parseObject();
-            Json parseArray();
-            Json parseString();
-            Json parseNumber();
-            Json parseLiteral();
+            // errorMsg is only turned into a string if the token is wrong
+            void expect(TokenType expected, const char* errorMsg);
+
+            // Each returns false if the handler asked to stop. Templates so the DOM builder's
+            // events are called directly rather than through the vtable
+            template <typename Handler> bool parseDocument(Handler& handler);
+            template <typename Handler> bool parseValue(Handler& handler);
+            template <typename Handler> bool parseObject(Handler& handler);
+            template <typename Handler> bool parseArray(Handler& handler);
+            template <typename Handler> bool parseNumber(Handler& handler);
+            template <typename Handler> bool parseLiteral(Handler& handler);
+
+            // Read past the current value without reporting it
+            void skipValue();
+            // Same, matching the brackets of a container rather than validating its contents
+            void skipUnchecked();
+            void skip(JsonHandler::Action action);
     };
 
 } 
@@ -0,0 +1,51 @@
+#ifndef JIBBY_JSON_POINTER_H
+#define JIBBY_JSON_POINTER_H
+
+#include "json.h"
+#include <string_view>
+
+namespace jibby {
+
+    // RFC 6901 JSON Pointer, e.g. "/items/0/price", compiled once and then resolved against any
+    // number of documents. Segments are unescaped ("~1" is '/', "~0" is '~') and hashed up front,
+    // and segments that can be array indices are converted once, so resolving never allocates
+    // or rehashes
+    class JsonPointer {
+        public:
+            // index() of a segment that is not an array index
+            static constexpr size_t NOT_INDEX = static_cast<size_t>(-1);
+
+            // Throws JsonException unless pointer is empty (the whole document) or starts with '/'
+            explicit JsonPointer(std::string_view pointer);
+
+            // The value pointer refers to in root, or nullptr if there is none
+            const Json* find(const Json& root) const;
+            Json* find(Json& root) const;
+
+            // Same, throwing JsonException naming the first segment that does not resolve
+            const Json& at(const Json& root) const;
+            Json& at(Json& root) const;
+
+            size_t size() const { return segments.size(); }
+            // Unescaped text of a segment, and its value as an array index or NOT_INDEX
+            std::string_view segment(size_t i) const { return segments[i].key; }
+            size_t index(size_t i) const { return segments[i].index; }
+            const string& toString() const { return text; }
+
+        private:
+            // Member key and, if the segment is a valid array index, that index
+            struct Segment {
+                JsonKey key;
+                size_t index;
+            };
+
+            string text;
+            vector<Segment> segments;
+
+            // Number of segments that resolve in root, and where the last of them leads
+            size_t resolve(const Json& root, const Json*& found) const;
+    };
+
+}
+
+#endif
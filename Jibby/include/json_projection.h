@@ -0,0 +1,92 @@
+#ifndef JIBBY_JSON_PROJECTION_H
+#define JIBBY_JSON_PROJECTION_H
+
+#include "json_handler.h"
+#include "json_types.h"
+#include <initializer_list>
+#include <string_view>
+
+namespace jibby {
+
+    // A set of paths to keep when parsing, for JsonParser::parse(const JsonProjection&). Paths
+    // are JSON Pointers (see JsonPointer) such as "/user/id", where a segment names an object
+    // member or an array index. A "*" segment matches every member or element. Everything under
+    // a matched path is kept; "" keeps the whole document. Kept array elements keep their indices,
+    // so every path still resolves in the result: elements before them that are not kept are
+    // null, and those after the last kept one are dropped
+    class JsonProjection {
+        public:
+            // No match, and everything below a matched path, as returned by child()
+            static constexpr size_t NONE = static_cast<size_t>(-1);
+            static constexpr size_t ALL = static_cast<size_t>(-2);
+
+            JsonProjection() = default;
+            JsonProjection(std::initializer_list<std::string_view> paths);
+            explicit JsonProjection(const vector<string>& paths);
+
+            // Throws JsonException if path is not a valid JSON Pointer
+            void add(std::string_view path);
+
+            // Path tree node for the document root, and for a child of node by key or index
+            size_t root() const;
+            size_t child(size_t node, std::string_view key) const;
+            size_t child(size_t node, size_t index) const;
+
+        private:
+            struct Segment {
+                string key;
+                size_t index; // key as an array index, NONE if it is not one
+                size_t node;
+            };
+
+            struct Node {
+                vector<Segment> children;
+                size_t wildcard = NONE;
+                bool whole = false; // a path ends here
+            };
+
+            vector<Node> nodes{Node()};
+
+            size_t matched(size_t node) const { return nodes[node].whole ? ALL : node; }
+    };
+
+    // Passes on to target only the events for values a projection keeps, skipping the rest
+    // unchecked from key() or element(), before they are decoded. Containers leading to a kept
+    // value are passed on even if nothing in them is kept, and skipped elements before a kept
+    // one are passed on as nulls
+    class JsonProjectingHandler final : public JsonHandler {
+        public:
+            JsonProjectingHandler(const JsonProjection& projection, JsonHandler& target);
+
+            Action startObject() override;
+            Action key(std::string_view name) override;
+            Action endObject() override;
+            Action startArray() override;
+            Action element() override;
+            Action endArray() override;
+            Action string(std::string_view value) override;
+            Action boolean(bool value) override;
+            Action null() override;
+            Action number(double value) override;
+            Action int64(int64_t value) override;
+            Action uint64(uint64_t value) override;
+
+        private:
+            struct Frame {
+                size_t node;
+                bool array;
+                size_t index;   // of the next element
+                size_t skipped; // elements skipped since the last kept one
+            };
+
+            const JsonProjection& projection;
+            JsonHandler& target;
+            vector<Frame> frames;
+            size_t pending; // path node of the next value
+
+            Action open(bool array);
+    };
+
+}
+
+#endif
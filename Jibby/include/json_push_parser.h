@@ -0,0 +1,116 @@
+#ifndef JIBBY_JSON_PUSH_PARSER_H
+#define JIBBY_JSON_PUSH_PARSER_H
+
+#include "json.h"
+#include "json_dom_builder.h"
+#include "json_exception.h"
+#include "json_handler.h"
+#include "json_key_pool.h"
+#include <string_view>
+
+namespace jibby {
+
+    // Parser for input that arrives in pieces, e.g. from a socket: each feed() parses as far as
+    // its bytes go and returns, keeping partial strings, escapes, numbers and literals and the
+    // stack of open containers for the next call. No piece is kept once fed, except the part of
+    // a string, number or literal it ends in. Input is validated and errors are reported as by
+    // JsonParser, with lines and columns counted across everything fed
+    class JsonPushParser {
+        public:
+            // Build a Json tree, taken with result() after finish(). resource and keys are used
+            // as by JsonParser and must outlive the result
+            explicit JsonPushParser(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                                    JsonKeyPool* keys = nullptr);
+
+            // Report events to handler, which must outlive the parser. Skip from a container
+            // suppresses its events, but its contents are still read and validated, as they
+            // may not have arrived yet; SkipUnchecked is the same as Skip here
+            explicit JsonPushParser(JsonHandler& handler);
+
+            JsonPushParser(const JsonPushParser&) = delete;
+            JsonPushParser& operator=(const JsonPushParser&) = delete;
+
+            // Parse the next piece of input, which need not outlive the call. Throws
+            // JsonParseException at the first error. Returns false once the handler has stopped
+            // the parse, after which further input is ignored
+            bool feed(const char* data, size_t length);
+            bool feed(std::string_view data) { return feed(data.data(), data.size()); }
+
+            // Signal the end of the input: completes a number or literal it ends in, and throws
+            // JsonParseException if the value is incomplete. Returns false if the handler stopped
+            bool finish();
+
+            // The tree built, moved out. Throws JsonException if events went to a handler or
+            // finish() has not been called
+            Json result();
+
+            // Bytes fed so far
+            size_t consumed() const { return base; }
+
+        private:
+            // What the grammar allows next
+            enum class Expect : uint8_t {
+                Value,
+                FirstValue, // after '[': a value or ']'
+                FirstKey,   // after '{': a key or '}'
+                Key,        // after ',' in an object
+                Colon,
+                CommaOrEnd,
+                Done        // the top-level value is complete
+            };
+
+            // Token left incomplete at the end of a piece
+            enum class Lexeme : uint8_t { None, String, Number, Literal };
+            enum class Escape : uint8_t { None, Backslash, Unicode };
+
+            JsonDomBuilder builder;
+            JsonHandler* handler;
+            bool building; // handler is the builder
+
+            Expect expect = Expect::Value;
+            vector<char> open; // '{' or '[' for each open container
+
+            Lexeme lexeme = Lexeme::None;
+            size_t lexemeStart = 0; // input offset where it began
+            string pending;         // its text so far, decoded for strings
+            Escape escape = Escape::None;
+            int hexDigits = 0;
+            unsigned codePoint = 0;
+
+            // Events are suppressed inside skipped containers, and for the value of a skipped key
+            size_t muted = 0;
+            bool muteNext = false;
+            bool stopped = false;
+            bool finished = false;
+
+            // Position of the piece being fed within the whole input, and the newlines before it
+            std::string_view piece;
+            size_t base = 0;
+            size_t lines = 0;
+            size_t lineStart = 0; // offset where the line containing base starts
+
+            size_t step(size_t pos);
+            size_t lexString(size_t pos);
+            size_t lexNumber(size_t pos);
+            size_t lexLiteral(size_t pos);
+            size_t resumeString(size_t pos);
+            void completeString(std::string_view text, size_t start);
+            // end is the position in piece after the token, npos at the end of the input
+            void completeNumber(std::string_view text, size_t start, size_t end);
+            void completeLiteral(std::string_view text, size_t start, size_t end);
+            void checkScalarEnd(size_t end);
+
+            void startValue();
+            void startContainer(char bracket, size_t offset);
+            void endContainer(char bracket, size_t offset);
+            void completeValue();
+            bool reporting();
+            void handle(JsonHandler::Action action);
+
+            [[noreturn]] void unexpected(size_t offset) const;
+            JsonParseException error(const string& msg, size_t offset) const;
+    };
+
+}
+
+#endif
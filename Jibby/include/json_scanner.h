@@ -0,0 +1,60 @@
+#ifndef JIBBY_JSON_SCANNER_H
+#define JIBBY_JSON_SCANNER_H
+
+#include "json_types.h"
+#include <cstdint>
+#include <string_view>
+
+namespace jibby {
+
+    // First parsing stage. Classifies the input 64 bytes at a time into whitespace, quotes,
+    // backslashes and structural characters, and builds an index of the offsets where tokens
+    // start. The block classifier uses SSE2 or AVX2 when the CPU supports them, picked at runtime
+    class JsonScanner {
+        public:
+            // Instruction sets the block classifier can run on
+            enum class Isa {
+                Scalar,
+                SSE2,
+                AVX2
+            };
+
+            // Number of input bytes indexed per call to nextWindow(), a multiple of the block size
+            static constexpr size_t WINDOW_SIZE = 16 * 1024;
+
+            explicit JsonScanner(std::string_view jsonText) : input(jsonText) {}
+
+            // Instruction set in use, the widest one the CPU supports unless restricted by setIsa()
+            static Isa isa();
+
+            // Restrict the scanner to an instruction set, e.g. to compare kernels. Requests above
+            // what the CPU supports fall back to the widest supported set
+            static void setIsa(Isa requested);
+
+            // Replace the contents of index with the offsets of the structural characters, opening
+            // quotes and scalar starts found in the next window of the input, in order.
+            // Returns false once the whole input has been indexed
+            bool nextWindow(vector<size_t>& index);
+
+            // Bulk helpers: the first non-whitespace offset at or after pos, and the first quote,
+            // backslash or control character at or after pos. Both return input.size() if none
+            static size_t skipWhitespace(std::string_view input, size_t pos);
+            static size_t findStringSpecial(std::string_view input, size_t pos);
+
+            // Character classes as JSON defines them, independent of the C locale
+            static bool isWhitespace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+            static bool isStructural(char c) {
+                return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+            }
+
+        private:
+            std::string_view input;
+            size_t pos = 0;
+            uint64_t prevInString = 0; // all ones when the previous block ended inside a string
+            uint64_t prevEscaped = 0;  // 1 when the previous block ended on an unfinished escape
+            uint64_t prevScalar = 0;   // 1 when the previous block ended on a scalar character
+    };
+
+}
+
+#endif
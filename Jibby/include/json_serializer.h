@@ -2,12 +2,17 @@
 #define JIBBY_JSON_SERIALIZER_H
 
 #include "json.h"
+#include <ostream>
 
 namespace jibby {
 
     class JsonSerializer {
         public:
             static string serialize(const Json& value, int indent = 0);
+
+            // Append to an existing string, or stream out without building the whole text first
+            static void serialize(const Json& value, string& out, int indent = 0);
+            static void serialize(const Json& value, std::ostream& out, int indent = 0);
     };
 
 }
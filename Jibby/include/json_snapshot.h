@@ -0,0 +1,116 @@
+#ifndef JIBBY_JSON_SNAPSHOT_H
+#define JIBBY_JSON_SNAPSHOT_H
+
+#include "json.h"
+#include "json_mapped_file.h"
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace jibby {
+
+    // One value of a JsonSnapshot. A small handle into the snapshot's bytes, cheap to copy and
+    // valid for as long as they are. Reading a value only follows offsets; nothing is decoded
+    // or allocated except by toJson()
+    class JsonSnapshotValue {
+        public:
+            // Walks the members of an object in insertion order, or the elements of an array.
+            // Keys are empty for array elements
+            class Iterator {
+                public:
+                    std::pair<std::string_view, JsonSnapshotValue> operator*() const;
+                    Iterator& operator++() { ++position; return *this; }
+                    bool operator!=(const Iterator& other) const { return position != other.position; }
+
+                private:
+                    friend class JsonSnapshotValue;
+                    std::string_view bytes;
+                    size_t slot; // of the container
+                    size_t position;
+                    Iterator(std::string_view bytes, size_t slot, size_t position)
+                        : bytes(bytes), slot(slot), position(position) {}
+            };
+
+            bool isNull() const;
+            bool isBoolean() const;
+            bool isNumber() const;
+            bool isString() const;
+            bool isObject() const;
+            bool isArray() const;
+
+            // Member count of an object or element count of an array
+            size_t size() const;
+            bool contains(std::string_view key) const;
+
+            // Lookups, throwing the same exceptions as Json's. Keys are found by binary search
+            JsonSnapshotValue operator[](std::string_view key) const;
+            JsonSnapshotValue operator[](size_t index) const;
+
+            // Scalars. Strings are views into the snapshot
+            std::string_view asString() const;
+            double asNumber() const;
+            int64_t asInt64() const;
+            uint64_t asUInt64() const;
+            bool asBoolean() const;
+
+            // A copy of the whole value as a Json tree
+            Json toJson() const;
+
+            // Iteration over an object or array (range-for)
+            Iterator begin() const;
+            Iterator end() const;
+
+        private:
+            friend class JsonSnapshot;
+            std::string_view bytes; // the whole snapshot
+            size_t slot;            // offset of this value's slot
+
+            JsonSnapshotValue(std::string_view bytes, size_t slot) : bytes(bytes), slot(slot) {}
+
+            uint8_t kind() const;
+            uint64_t payload() const;
+            size_t count() const;
+            size_t block(uint8_t expected, size_t stride) const;
+            std::string_view text(size_t offset, size_t length) const;
+            std::string_view key(size_t block, size_t index) const;
+            std::optional<JsonSnapshotValue> find(std::string_view key) const;
+            Json scalar() const;
+    };
+
+    // A Json tree stored in a form that is read in place: every value is a fixed-size slot, and
+    // strings and containers are reached by offset from the start, so a mapped file needs no
+    // pointer fixups and opening one costs a header check. Object members keep their insertion
+    // order alongside an index sorted by key. The layout is little-endian on every platform.
+    // Offsets are checked as they are followed, so a damaged file throws JsonException rather
+    // than reading out of bounds
+    class JsonSnapshot {
+        public:
+            // Format version written to and required in the header
+            static constexpr uint32_t VERSION = 1;
+
+            // Use caller-owned bytes, which must outlive the snapshot and its values
+            explicit JsonSnapshot(std::string_view bytes);
+            // Take over a file mapping, as from Json::loadSnapshot()
+            explicit JsonSnapshot(JsonMappedFile&& file);
+
+            // Values point at the bytes, so the snapshot stays where it was built
+            JsonSnapshot(const JsonSnapshot&) = delete;
+            JsonSnapshot& operator=(const JsonSnapshot&) = delete;
+
+            JsonSnapshotValue root() const;
+
+            // Snapshot bytes for a Json tree. Throws JsonException for a string or container too
+            // large for the format's 32-bit lengths
+            static string encode(const Json& value);
+
+        private:
+            std::optional<JsonMappedFile> file;
+            std::string_view bytes;
+
+            void checkHeader() const;
+    };
+
+}
+
+#endif
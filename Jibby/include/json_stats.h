@@ -0,0 +1,116 @@
+#ifndef JIBBY_JSON_STATS_H
+#define JIBBY_JSON_STATS_H
+
+#include "json.h"
+#include <atomic>
+#include <functional>
+#include <memory_resource>
+#include <string_view>
+
+// Statistics are only collected when the library is built with JIBBY_STATS defined (the CMake
+// option of the same name). Otherwise the counting code is compiled out entirely, collect()
+// does nothing, and the stats objects stay zero
+#if defined(JIBBY_STATS)
+#define JIBBY_STAT(stats, statement) do { if (stats) { statement; } } while (false)
+#else
+#define JIBBY_STAT(stats, statement) do {} while (false)
+#endif
+
+namespace jibby {
+
+    // Receives each statistic by name, e.g. to forward them to a metrics system
+    using JsonMetricSink = std::function<void(std::string_view name, double value)>;
+
+    // What JsonParser and its JsonTokenizer saw, for parsers given the object with collect().
+    // Counts add up across parses, so one object can total a whole endpoint; assign {} to
+    // start over. Values skipped by a projection, a handler or validate() count as tokens
+    // and bytes only
+    struct JsonParseStats {
+        static constexpr bool ENABLED =
+#if defined(JIBBY_STATS)
+            true;
+#else
+            false;
+#endif
+
+        size_t parses = 0;
+        size_t bytes = 0;           // input read by the tokenizer
+        size_t tokens = 0;
+        size_t objects = 0;
+        size_t arrays = 0;
+        size_t members = 0;         // object keys
+        size_t strings = 0;         // string values and keys
+        size_t stringBytes = 0;     // their text as it appears in the input, quotes excluded
+        size_t escapedStrings = 0;  // strings that needed unescaping
+        size_t unescapedBytes = 0;  // decoded text of those strings
+        size_t numbers = 0;
+        size_t literals = 0;        // true, false and null
+        size_t maxDepth = 0;        // deepest nesting of objects and arrays
+        // Made from the parser's memory resource, when that is a JsonCountingResource
+        size_t allocations = 0;
+        size_t allocatedBytes = 0;
+
+        // Wall time spent in parse calls, and the part of it spent producing tokens. The
+        // tokenizer is only timed when timeTokenizer is set, as it takes a clock reading per
+        // token; the rest of seconds is then the time spent building the tree or handling events
+        double seconds = 0.0;
+        double tokenizeSeconds = 0.0;
+        bool timeTokenizer = false;
+
+        JsonParseStats& operator+=(const JsonParseStats& other);
+
+        // Each statistic under a snake_case name, e.g. "string_bytes", plus "build_seconds"
+        void report(const JsonMetricSink& sink) const;
+        // The same, as an object
+        Json toJson() const;
+    };
+
+    // What JsonWriter wrote, for writers given the object with collect(). Counts add up like
+    // JsonParseStats'
+    struct JsonWriteStats {
+        static constexpr bool ENABLED = JsonParseStats::ENABLED;
+
+        size_t writes = 0;
+        size_t bytes = 0;           // output produced, including any a fixed buffer dropped
+        size_t objects = 0;
+        size_t arrays = 0;
+        size_t members = 0;
+        size_t strings = 0;         // string values and keys
+        size_t stringBytes = 0;     // their text before escaping
+        size_t escapes = 0;         // characters written as escape sequences
+        size_t numbers = 0;
+        size_t literals = 0;
+        size_t maxDepth = 0;
+        size_t flushes = 0;         // writes to a stream sink
+        double seconds = 0.0;
+
+        JsonWriteStats& operator+=(const JsonWriteStats& other);
+
+        void report(const JsonMetricSink& sink) const;
+        Json toJson() const;
+    };
+
+    // Memory resource counting what is allocated through it before passing the requests on to
+    // upstream. Parse with one to have allocations show in JsonParseStats. Counts are atomic,
+    // so it can be shared by parsers on several threads
+    class JsonCountingResource : public std::pmr::memory_resource {
+        public:
+            explicit JsonCountingResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+                : upstream(upstream) {}
+
+            size_t allocations() const { return allocationCount.load(std::memory_order_relaxed); }
+            size_t allocatedBytes() const { return byteCount.load(std::memory_order_relaxed); }
+
+        private:
+            std::pmr::memory_resource* upstream;
+            std::atomic<size_t> allocationCount{0};
+            std::atomic<size_t> byteCount{0};
+
+            void* do_allocate(size_t bytes, size_t alignment) override;
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+}
+
+#endif
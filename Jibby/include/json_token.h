@@ -21,18 +21,21 @@ namespace jibby {
         END_OF_FILE
     };
 
-    // Token attributes with default values
+    // Token attributes with default values. A token does not own its text: offset/length
+    // span the token in the tokenizer's input (the contents between the quotes for strings).
+    // Strings containing escapes are decoded only when read, see JsonTokenizer::text().
+    // Line and column are worked out from the offset when needed, see JsonTokenizer::locate()
     struct Token {
         TokenType type = TokenType::END_OF_FILE;
-        string value = ""; 
-        size_t line = 1;
-        size_t column = 1;
+        size_t offset = 0;
+        size_t length = 0;
+        bool escaped = false;
 
         // Constructors
         Token() = default;
 
-        Token(TokenType t, const string& v = "", size_t l = 1, size_t c = 1)
-            : type(t), value(v), line(l), column(c) {}
+        Token(TokenType t, size_t o, size_t len)
+            : type(t), offset(o), length(len) {}
     };
 
 }
@@ -4,28 +4,102 @@
 #include "json.h"
 #include "json_token.h"
 #include "json_exception.h"
+#include "json_number.h"
+#include "json_scanner.h"
+#include "json_stats.h"
+#include <functional>
+#include <string_view>
 
 namespace jibby {
 
+    // Pulls streamed input: fills buffer with up to capacity bytes and returns how many were
+    // written, 0 once the input is exhausted
+    using JsonSource = std::function<size_t(char* buffer, size_t capacity)>;
+
     class JsonTokenizer {
         private:
-            const string input;
+            std::string_view input; // caller-owned buffer, never copied
+            mutable string scratch; // decoded text of the last escaped string read with text()
+            JsonNumber number;      // decomposition of the last number token
             size_t pos = 0;
-            size_t line = 1;
-            size_t column = 1;
+
+            // Structural index built by the scanner, one window at a time. Tokens start at the
+            // indexed offsets, so whitespace is never walked character by character
+            JsonScanner scanner;
+            vector<size_t> index;
+            size_t cursor = 0;
+
+            // Streamed input is read chunk by chunk into buffer, which input then views. Text
+            // before the current token is dropped as the buffer is refilled, so tokens may cross
+            // chunk boundaries while memory stays bounded by the chunk size plus one token.
+            // The structural index is not used when streaming
+            JsonSource source;
+            string buffer;
+            size_t chunkSize = 0;
+            size_t base = 0;              // stream offset of input[0]
+            size_t droppedLines = 0;      // newlines in the dropped text
+            size_t droppedLineStart = 0;  // stream offset where the line containing input[0] starts
+
+            // Text of the enclosing document before input, when only a range of it is parsed.
+            // Only read to locate errors
+            std::string_view preceding;
+
+            JsonParseStats* stats = nullptr;
 
         public:
-            explicit JsonTokenizer(const string& jsonText) : input(jsonText) {}
+            // Default chunk size for streamed input
+            static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+            explicit JsonTokenizer(std::string_view jsonText) : input(jsonText), scanner(jsonText) {}
+            JsonTokenizer(JsonSource source, size_t chunkSize);
+            // Tokenize document[begin, end), locating errors within the whole document
+            JsonTokenizer(std::string_view document, size_t begin, size_t end);
             Token getNextToken();
 
+            // Text of a token: a view into the input, or into the scratch buffer for strings with
+            // escapes, which are decoded on this call. Only valid until the next call to
+            // getNextToken() or text()
+            std::string_view text(const Token& token) const;
+
+            // Digits and exponent of the last NUMBER token, read while it was validated
+            const JsonNumber& numberValue() const;
+
+            // The whole input when it is one buffer held in memory, empty when it is streamed or a
+            // range of a larger document
+            std::string_view document() const { return source || base > 0 ? std::string_view() : input; }
+
+            // Count tokens and strings into stats, starting with last, the token already read, or
+            // stop counting if stats is null. No-op unless built with JIBBY_STATS
+            void collect(JsonParseStats* stats, const Token& last);
+
+            // Input read so far, from the start of the text being tokenized
+            size_t consumed() const { return base - preceding.size() + pos; }
+
+            // Line and column of an input offset. Only worked out when an error is reported
+            void locate(size_t offset, size_t& line, size_t& column) const;
+
+            // Move past the object or array whose opening bracket, open, was the last token, by
+            // matching brackets in the structural index. The next token is the one after its
+            // closing bracket. Throws JsonParseException at a closing bracket of the wrong kind.
+            // Returns false, having done nothing, for streamed input
+            bool skipContainer(char open);
+
+            // Parse error pointing at an input offset
+            JsonParseException error(const string& msg, size_t offset) const;
+
         private:
-            char peek() const;
-            char advance();
-            void skipWhitespace();
-            Token stringToken();
-            Token numberToken(char c);
-            Token literalToken(char c);
-            bool isAtEnd() const;
+            Token readToken();
+            void count(const Token& token);
+            char peek();
+            size_t nextStructural();
+            size_t nextStreamed();
+            bool fill();
+            void compact();
+            void expectScalarEnd();
+            Token stringToken(size_t start);
+            Token numberToken(size_t start);
+            Token literalToken(size_t start);
+            bool isAtEnd();
     };
 
 }
@@ -1,6 +1,7 @@
 #ifndef JIBBY_JSON_TYPES_H
 #define JIBBY_JSON_TYPES_H
 
+#include <memory_resource>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -9,6 +10,7 @@
 namespace jibby {
     // Forward declare Json class for compiler processing 
     class Json;
+    class JsonObject;
 
     // Type aliases to make typing cleaner throughout codebase
     using string = std::string;
@@ -22,8 +24,17 @@ namespace jibby {
     template<typename... Ts>
     using variant = std::variant<Ts...>;
 
-    using Object = hashmap<string, Json>;
-    using Array = vector<Json>;
+    // Json values keep their strings and containers in std::pmr types, so a whole tree can be
+    // allocated from one memory resource (see JsonDocument). By default they use the heap as usual
+    using JsonString = std::pmr::string;
+    using Object = JsonObject; // insertion-ordered, see json_object.h
+    using Array = std::pmr::vector<Json>;
+
+    // Binary encodings, see json_binary.h
+    enum class JsonBinaryFormat {
+        MessagePack,
+        Cbor  // RFC 8949
+    };
 }
 
 #endif
\ No newline at end of file
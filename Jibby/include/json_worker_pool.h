@@ -0,0 +1,46 @@
+#ifndef JIBBY_JSON_WORKER_POOL_H
+#define JIBBY_JSON_WORKER_POOL_H
+
+#include "json_types.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace jibby {
+
+    // Fixed set of threads running submitted tasks in submission order, for the parallel readers
+    class JsonWorkerPool {
+        public:
+            // threads == 0 uses one per hardware thread
+            explicit JsonWorkerPool(size_t threads = 0);
+
+            JsonWorkerPool(const JsonWorkerPool&) = delete;
+            JsonWorkerPool& operator=(const JsonWorkerPool&) = delete;
+
+            // Runs every task already submitted, then joins the threads
+            ~JsonWorkerPool();
+
+            size_t size() const { return workers.size(); }
+
+            // Queue a task. The future becomes ready when it has run, and rethrows what it threw.
+            // Called from one of the pool's own tasks, it runs the task at once instead: callers
+            // such as JsonLinesReader::forEach() wait on what they submit, which behind the caller
+            // in the queue would never run
+            std::future<void> submit(std::function<void()> task);
+
+        private:
+            vector<std::thread> workers;
+            std::deque<std::packaged_task<void()>> tasks;
+            std::mutex mutex;
+            std::condition_variable available;
+            bool stopping = false;
+
+            void run();
+    };
+
+}
+
+#endif
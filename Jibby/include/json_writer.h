@@ -0,0 +1,74 @@
+#ifndef JIBBY_JSON_WRITER_H
+#define JIBBY_JSON_WRITER_H
+
+#include "json.h"
+#include "json_stats.h"
+#include <ostream>
+#include <string_view>
+
+namespace jibby {
+
+    // Streaming serializer: appends JSON text to one growable buffer or a caller-supplied sink
+    // instead of building a string per node
+    class JsonWriter {
+        public:
+            // Stream output is staged in chunks of this many bytes
+            static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+            // Append to a caller-owned string
+            explicit JsonWriter(string& out);
+
+            // Write to a stream, buffered
+            explicit JsonWriter(std::ostream& out);
+
+            // Write into a fixed caller buffer. Output past capacity is dropped and reported by overflowed()
+            JsonWriter(char* buffer, size_t size);
+
+            JsonWriter(const JsonWriter&) = delete;
+            JsonWriter& operator=(const JsonWriter&) = delete;
+
+            // Flushes any staged stream output
+            ~JsonWriter();
+
+            // Serialize a value. indent > 0 pretty-prints with that many spaces per level, starting
+            // at nesting level depth
+            void write(const Json& value, int indent = 0, int depth = 0);
+
+            // Push staged output to the stream sink
+            void flush();
+
+            // Bytes produced so far, including any dropped by a fixed buffer
+            size_t size() const { return written; }
+
+            // True if a fixed buffer was too small for the output
+            bool overflowed() const { return overflow; }
+
+            // Add what the following writes produce to stats, which must outlive them. No-op unless
+            // built with JIBBY_STATS
+            void collect(JsonWriteStats& stats);
+
+        private:
+            string* target = nullptr;       // caller's string, or the staging buffer for streams
+            string staging;
+            std::ostream* stream = nullptr;
+            char* fixed = nullptr;
+            size_t capacity = 0;
+            size_t written = 0;
+            bool overflow = false;
+            JsonWriteStats* stats = nullptr;
+            size_t level = 0; // nesting of the container being written, tracked for stats
+
+            void append(const char* data, size_t length);
+            void append(std::string_view text) { append(text.data(), text.size()); }
+            void append(char c);
+            void appendSpaces(size_t count);
+            void newline(int indent, int depth);
+
+            void writeValue(const Json& value, int indent, int depth);
+            void writeNumber(const Json& value);
+            void writeString(std::string_view text);
+    };
+
+}
+
+#endif
@@ -1,52 +1,49 @@
 #include "json.h"
+#include "json_binary.h"
 #include "json_exception.h"
 #include "json_iterator.h"
 #include "json_io.h"
-#include <sstream>
+#include "json_lazy.h"
+#include "json_pointer.h"
+#include "json_snapshot.h"
+#include "json_writer.h"
+#include <fstream>
+#include <limits>
 
 using namespace std; // Safe here in a .cpp file only
 
 namespace jibby {
 
-namespace {
-
-string escapeJsonString(const string& input) {
-    ostringstream oss;
-
-    for (unsigned char c : input) {
-        switch (c) {
-            case '\"': oss << "\\\""; break;
-            case '\\': oss << "\\\\"; break;
-            case '\b': oss << "\\b"; break;
-            case '\f': oss << "\\f"; break;
-            case '\n': oss << "\\n"; break;
-            case '\r': oss << "\\r"; break;
-            case '\t': oss << "\\t"; break;
-            default:
-                if (c < 0x20) {
-                    static const char* hex = "0123456789abcdef";
-                    oss << "\\u00" << hex[(c >> 4) & 0x0F] << hex[c & 0x0F];
-                } else {
-                    oss << static_cast<char>(c);
-                }
-                break;
-        }
-    }
-
-    return oss.str();
-}
-
-} // namespace
-
 // ---- Constructors ----
 Json::Json() : type(Type::Null), value(nullptr) {}
 Json::Json(std::nullptr_t) : type(Type::Null), value(nullptr) {}
 Json::Json(bool b) : type(Type::Boolean), value(b) {}
 Json::Json(double num) : type(Type::Number), value(num) {}
-Json::Json(const string& str) : type(Type::String), value(str) {}
-Json::Json(const char* str) : type(Type::String), value(string(str)) {}
+Json::Json(const string& str) : type(Type::String), value(JsonString(str.data(), str.size())) {}
+Json::Json(const char* str) : type(Type::String), value(JsonString(str)) {}
 Json::Json(const Object& obj) : type(Type::Object), value(obj) {}
 Json::Json(const Array& arr) : type(Type::Array), value(arr) {}
+Json::Json(const JsonString& str) : type(Type::String), value(str) {}
+Json::Json(JsonString&& str) : type(Type::String), value(std::move(str)) {}
+Json::Json(Object&& obj) : type(Type::Object), value(std::move(obj)) {}
+Json::Json(Array&& arr) : type(Type::Array), value(std::move(arr)) {}
+
+// ---- Number Representation ----
+bool Json::isInteger() const {
+    return holds_alternative<int64_t>(value) || holds_alternative<uint64_t>(value);
+}
+
+bool Json::isInt64() const {
+    if (holds_alternative<int64_t>(value)) return true;
+    auto u = get_if<uint64_t>(&value);
+    return u && *u <= static_cast<uint64_t>(numeric_limits<int64_t>::max());
+}
+
+bool Json::isUInt64() const {
+    if (holds_alternative<uint64_t>(value)) return true;
+    auto i = get_if<int64_t>(&value);
+    return i && *i >= 0;
+}
 
 // ---- Const Accessors ----
 const Object& Json::asObject() const {
@@ -59,16 +56,34 @@ const Array& Json::asArray() const {
     return get<Array>(value);
 }
 
-const string& Json::asString() const {
+std::string_view Json::asString() const {
+    return asJsonString();
+}
+
+const JsonString& Json::asJsonString() const {
     if (!isString()) throw JsonException("Json value is not a string");
-    return get<string>(value);
+    return get<JsonString>(value);
 }
 
 double Json::asNumber() const {
     if (!isNumber()) throw JsonException("Json value is not a number");
+    if (auto i = get_if<int64_t>(&value)) return static_cast<double>(*i);
+    if (auto u = get_if<uint64_t>(&value)) return static_cast<double>(*u);
     return get<double>(value);
 }
 
+int64_t Json::asInt64() const {
+    if (!isInt64()) throw JsonException("Json value is not an int64 number");
+    if (auto u = get_if<uint64_t>(&value)) return static_cast<int64_t>(*u);
+    return get<int64_t>(value);
+}
+
+uint64_t Json::asUInt64() const {
+    if (!isUInt64()) throw JsonException("Json value is not a uint64 number");
+    if (auto i = get_if<int64_t>(&value)) return static_cast<uint64_t>(*i);
+    return get<uint64_t>(value);
+}
+
 bool Json::asBoolean() const {
     if (!isBoolean()) throw JsonException("Json value is not a boolean");
     return get<bool>(value);
@@ -85,13 +100,14 @@ Array& Json::asArray() {
     return get<Array>(value);
 }
 
-string& Json::asString() {
+JsonString& Json::asJsonString() {
     if (!isString()) throw JsonException("Json value is not a string");
-    return get<string>(value);
+    return get<JsonString>(value);
 }
 
 double& Json::asNumber() {
     if (!isNumber()) throw JsonException("Json value is not a number");
+    if (isInteger()) value = static_cast<const Json&>(*this).asNumber();
     return get<double>(value);
 }
 
@@ -99,9 +115,28 @@ bool& Json::asBoolean() {
     if (!isBoolean()) throw JsonException("Json value is not a boolean");
     return get<bool>(value);
 }
+
+// ---- Move-out Accessors ----
+JsonString Json::takeString() {
+    JsonString str = std::move(asJsonString());
+    *this = nullptr;
+    return str;
+}
+
+Object Json::takeObject() {
+    Object obj = std::move(asObject());
+    *this = nullptr;
+    return obj;
+}
+
+Array Json::takeArray() {
+    Array arr = std::move(asArray());
+    *this = nullptr;
+    return arr;
+}
 
 // ---- Index Operators ----
-const Json& Json::operator[](const string& key) const {
+const Json& Json::operator[](std::string_view key) const {
     if (!isObject()) {
         throw JsonException("Cannot use operator[] on non-object JSON value");
     }
@@ -109,7 +144,7 @@ const Json& Json::operator[](const string& key) const {
     const auto& obj = asObject();
     auto it = obj.find(key);
     if (it == obj.end()) {
-        throw JsonException("Key not found: " + key);
+        throw JsonException("Key not found: " + string(key));
     }
     return it->second;
 }
@@ -125,7 +160,56 @@ const Json& Json::operator[](size_t index) const {
     return arr[index];
 }
 
-Json& Json::operator[](const string& key) {
+// ---- Non-throwing Lookups ----
+const Json* Json::find(std::string_view key) const {
+    if (!isObject()) return nullptr;
+    const auto& obj = get<Object>(value);
+    auto it = obj.find(key);
+    return it == obj.end() ? nullptr : &it->second;
+}
+
+const Json* Json::find(const JsonKey& key) const {
+    if (!isObject()) return nullptr;
+    const auto& obj = get<Object>(value);
+    auto it = obj.find(key);
+    return it == obj.end() ? nullptr : &it->second;
+}
+
+const Json* Json::find(size_t index) const {
+    if (!isArray()) return nullptr;
+    const auto& arr = get<Array>(value);
+    return index < arr.size() ? &arr[index] : nullptr;
+}
+
+const Json* Json::find(const JsonPointer& pointer) const {
+    return pointer.find(*this);
+}
+
+Json* Json::find(std::string_view key) {
+    return const_cast<Json*>(static_cast<const Json&>(*this).find(key));
+}
+
+Json* Json::find(const JsonKey& key) {
+    return const_cast<Json*>(static_cast<const Json&>(*this).find(key));
+}
+
+Json* Json::find(size_t index) {
+    return const_cast<Json*>(static_cast<const Json&>(*this).find(index));
+}
+
+Json* Json::find(const JsonPointer& pointer) {
+    return pointer.find(*this);
+}
+
+const Json& Json::at(const JsonPointer& pointer) const {
+    return pointer.at(*this);
+}
+
+Json& Json::at(const JsonPointer& pointer) {
+    return pointer.at(*this);
+}
+
+Json& Json::operator[](std::string_view key) {
     if (!isObject()) {
         throw JsonException("Cannot use operator[] on non-object JSON value");
     }
@@ -152,16 +236,27 @@ Json Json::array() {
     return Json(Array{});
 }
 
+Json Json::object(std::pmr::memory_resource* resource) {
+    return Json(Object(resource));
+}
+
+Json Json::array(std::pmr::memory_resource* resource) {
+    return Json(Array(resource));
+}
+
 // ---- Assignment Operators ----
+// Assigning over an existing string reuses its memory resource
 Json& Json::operator=(const string& str) {
     type = Type::String;
-    value = str;
+    if (auto current = get_if<JsonString>(&value)) current->assign(str.data(), str.size());
+    else value = JsonString(str.data(), str.size());
     return *this;
 }
 
 Json& Json::operator=(const char* str) {
     type = Type::String;
-    value = string(str);
+    if (auto current = get_if<JsonString>(&value)) current->assign(str);
+    else value = JsonString(str);
     return *this;
 }
 
@@ -179,96 +274,97 @@ Json& Json::operator=(std::nullptr_t) {
 
 // ---- Iteration ---- 
 JsonIterator Json::begin() {
-    if (isObject()) return JsonIterator(asObject().begin());
-    if (isArray())  return JsonIterator(asArray().begin());
+    if (isObject()) return JsonIterator(asObject().members.data());
+    if (isArray())  return JsonIterator(asArray().data());
     throw JsonException("Cannot iterate over non-object/array JSON value");
 }
 
 JsonIterator Json::end() {
-    if (isObject()) return JsonIterator(asObject().end());
-    if (isArray())  return JsonIterator(asArray().end());
+    if (isObject()) return begin() + static_cast<std::ptrdiff_t>(asObject().size());
+    if (isArray())  return JsonIterator(asArray().data() + asArray().size());
     throw JsonException("Cannot iterate over non-object/array JSON value");
 }
 
-JsonIterator Json::begin() const {
-    if (isObject()) return JsonIterator(asObject().begin());
-    if (isArray())  return JsonIterator(asArray().begin());
+JsonConstIterator Json::begin() const {
+    if (isObject()) return JsonConstIterator(asObject().members.data());
+    if (isArray())  return JsonConstIterator(asArray().data());
     throw JsonException("Cannot iterate over non-object/array JSON value");
 }
 
-JsonIterator Json::end() const {
-    if (isObject()) return JsonIterator(asObject().end());
-    if (isArray())  return JsonIterator(asArray().end());
+JsonConstIterator Json::end() const {
+    if (isObject()) return begin() + static_cast<std::ptrdiff_t>(asObject().size());
+    if (isArray())  return JsonConstIterator(asArray().data() + asArray().size());
     throw JsonException("Cannot iterate over non-object/array JSON value");
 }
 
+JsonRange<JsonIterator> Json::members() {
+    asObject();
+    return {begin(), end()};
+}
+
+JsonRange<JsonConstIterator> Json::members() const {
+    asObject();
+    return {begin(), end()};
+}
+
+JsonRange<Array::iterator> Json::elements() {
+    Array& arr = asArray();
+    return {arr.begin(), arr.end()};
+}
+
+JsonRange<Array::const_iterator> Json::elements() const {
+    const Array& arr = asArray();
+    return {arr.begin(), arr.end()};
+}
+
 // ---- File I/O ----
 Json Json::load(const string& filepath) {
     return JsonIO::read(filepath);
 }
 
+JsonLazyDocument Json::loadLazy(const string& filepath) {
+    return JsonLazyDocument(JsonMappedFile(filepath));
+}
+
 void Json::save(const string& filepath, bool pretty) const {
     JsonIO::write(*this, filepath, pretty);
 }
 
+JsonSnapshot Json::loadSnapshot(const string& filepath) {
+    return JsonSnapshot(JsonMappedFile(filepath));
+}
+
+void Json::saveSnapshot(const string& filepath) const {
+    const string bytes = JsonSnapshot::encode(*this);
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        throw JsonException("Failed to open file for writing: " + filepath);
+    }
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    file.close();
+    if (!file) {
+        throw JsonException("Error occurred while writing file: " + filepath);
+    }
+}
+
 // ---- Serialization ----
 string Json::serialize(int indent, int depth) const {
-    ostringstream oss;
-
-    switch (type) {
-        case Type::Null:
-            oss << "null";
-            break;
-        case Type::Boolean:
-            oss << (get<bool>(value) ? "true" : "false");
-            break;
-        case Type::Number:
-            oss << get<double>(value);
-            break;
-        case Type::String:
-            oss << "\"" << escapeJsonString(get<string>(value)) << "\"";
-            break;
-
-        case Type::Object: {
-            const auto& obj = get<Object>(value);
-            oss << "{";
-            bool first = true;
-            for (const auto& [key, val] : obj) {
-                if (!first) oss << ",";
-                if (indent > 0) {
-                    oss << "\n" << string(indent * (depth + 1), ' ');
-                }
-                oss << "\"" << escapeJsonString(key) << "\": " << val.serialize(indent, depth + 1);
-                first = false;
-            }
-            if (indent > 0 && !obj.empty()) {
-                oss << "\n" << string(indent * depth, ' ');
-            }
-            oss << "}";
-            break;
-        }
-
-        case Type::Array: {
-            const auto& arr = get<Array>(value);
-            oss << "[";
-            bool first = true;
-            for (const auto& val : arr) {
-                if (!first) oss << ",";
-                if (indent > 0) {
-                    oss << "\n" << string(indent * (depth + 1), ' ');
-                }
-                oss << val.serialize(indent, depth + 1);
-                first = false;
-            }
-            if (indent > 0 && !arr.empty()) {
-                oss << "\n" << string(indent * depth, ' ');
-            }
-            oss << "]";
-            break;
-        }
-    }
+    string out;
+    JsonWriter(out).write(*this, indent, depth);
+    return out;
+}
+
+string Json::toBinary(JsonBinaryFormat format) const {
+    string out;
+    JsonBinaryWriter(out, format).write(*this);
+    return out;
+}
 
-    return oss.str();
+Json Json::fromBinary(std::string_view bytes, JsonBinaryFormat format) {
+    JsonBinaryReader reader(bytes, format);
+    Json value = reader.read();
+    if (!reader.atEnd()) throw JsonException("Unexpected trailing bytes after binary value");
+    return value;
 }
 
 }
@@ -0,0 +1,571 @@
+#include "json_binary.h"
+#include "json_exception.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+namespace jibby {
+
+namespace {
+
+// Most entries reserved up front for an array or map of a length read from the input
+constexpr size_t MAX_RESERVE = 4096;
+
+// Integers decode as int64 where they fit, as the text parser stores them
+Json integer(uint64_t value) {
+    if (value <= static_cast<uint64_t>(numeric_limits<int64_t>::max())) return Json(static_cast<int64_t>(value));
+    return Json(value);
+}
+
+// True if value survives a round trip through a 32-bit float
+bool fitsFloat(double value) {
+    return std::isfinite(value) && static_cast<double>(static_cast<float>(value)) == value
+        ? true : std::isinf(value);
+}
+
+uint32_t floatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+uint64_t doubleBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float bitsFloat(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+double bitsDouble(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// IEEE 754 half precision, which CBOR encoders may use for small floats
+double halfFloat(uint16_t half) {
+    const int exponent = (half >> 10) & 0x1f;
+    const int mantissa = half & 0x3ff;
+    double value;
+    if (exponent == 0) value = std::ldexp(mantissa, -24);
+    else if (exponent != 31) value = std::ldexp(mantissa + 1024, exponent - 25);
+    else value = mantissa == 0 ? numeric_limits<double>::infinity() : numeric_limits<double>::quiet_NaN();
+    return (half & 0x8000) ? -value : value;
+}
+
+} // namespace
+
+// ---- JsonBinaryWriter ----
+
+JsonBinaryWriter::JsonBinaryWriter(string& out, JsonBinaryFormat format) : target(&out), format(format) {}
+
+JsonBinaryWriter::JsonBinaryWriter(std::ostream& out, JsonBinaryFormat format)
+    : target(&staging), stream(&out), format(format) {
+    staging.reserve(BUFFER_SIZE);
+}
+
+JsonBinaryWriter::~JsonBinaryWriter() {
+    flush();
+}
+
+void JsonBinaryWriter::flush() {
+    if (stream && !staging.empty()) {
+        stream->write(staging.data(), static_cast<std::streamsize>(staging.size()));
+        staging.clear();
+    }
+}
+
+void JsonBinaryWriter::write(const Json& value) {
+    if (format == JsonBinaryFormat::MessagePack) writeMessagePack(value);
+    else writeCbor(value);
+}
+
+void JsonBinaryWriter::appendBigEndian(uint64_t value, size_t bytes) {
+    char out[8];
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<char>(value >> (8 * (bytes - 1 - i)));
+    }
+    append(out, bytes);
+}
+
+// ---- MessagePack ----
+
+void JsonBinaryWriter::writeMessagePack(const Json& value) {
+    if (stream && staging.size() >= BUFFER_SIZE) flush();
+    switch (value.type) {
+        case Json::Type::Null:
+            append(uint8_t(0xc0));
+            break;
+
+        case Json::Type::Boolean:
+            append(uint8_t(get<bool>(value.value) ? 0xc3 : 0xc2));
+            break;
+
+        case Json::Type::Number:
+            if (auto i = get_if<int64_t>(&value.value)) writeMessagePackSigned(*i);
+            else if (auto u = get_if<uint64_t>(&value.value)) writeMessagePackUnsigned(*u);
+            else writeMessagePackDouble(get<double>(value.value));
+            break;
+
+        case Json::Type::String: {
+            const auto& str = get<JsonString>(value.value);
+            writeMessagePackLength(str.size(), 0xa0, 32, 0xd9, 0xda);
+            append(str.data(), str.size());
+            break;
+        }
+
+        case Json::Type::Array: {
+            const auto& arr = get<Array>(value.value);
+            writeMessagePackLength(arr.size(), 0x90, 16, 0, 0xdc);
+            for (const auto& element : arr) writeMessagePack(element);
+            break;
+        }
+
+        case Json::Type::Object: {
+            const auto& obj = get<Object>(value.value);
+            writeMessagePackLength(obj.size(), 0x80, 16, 0, 0xde);
+            for (const auto& [key, member] : obj) {
+                writeMessagePackLength(key.size(), 0xa0, 32, 0xd9, 0xda);
+                append(key.data(), key.size());
+                writeMessagePack(member);
+            }
+            break;
+        }
+    }
+}
+
+void JsonBinaryWriter::writeMessagePackUnsigned(uint64_t value) {
+    if (value < 0x80) {
+        append(static_cast<uint8_t>(value));
+    } else if (value <= 0xff) {
+        append(uint8_t(0xcc));
+        appendBigEndian(value, 1);
+    } else if (value <= 0xffff) {
+        append(uint8_t(0xcd));
+        appendBigEndian(value, 2);
+    } else if (value <= 0xffffffffu) {
+        append(uint8_t(0xce));
+        appendBigEndian(value, 4);
+    } else {
+        append(uint8_t(0xcf));
+        appendBigEndian(value, 8);
+    }
+}
+
+void JsonBinaryWriter::writeMessagePackSigned(int64_t value) {
+    if (value >= 0) {
+        writeMessagePackUnsigned(static_cast<uint64_t>(value));
+    } else if (value >= -32) {
+        append(static_cast<uint8_t>(value)); // negative fixint
+    } else if (value >= numeric_limits<int8_t>::min()) {
+        append(uint8_t(0xd0));
+        appendBigEndian(static_cast<uint64_t>(value), 1);
+    } else if (value >= numeric_limits<int16_t>::min()) {
+        append(uint8_t(0xd1));
+        appendBigEndian(static_cast<uint64_t>(value), 2);
+    } else if (value >= numeric_limits<int32_t>::min()) {
+        append(uint8_t(0xd2));
+        appendBigEndian(static_cast<uint64_t>(value), 4);
+    } else {
+        append(uint8_t(0xd3));
+        appendBigEndian(static_cast<uint64_t>(value), 8);
+    }
+}
+
+void JsonBinaryWriter::writeMessagePackDouble(double value) {
+    if (fitsFloat(value)) {
+        append(uint8_t(0xca));
+        appendBigEndian(floatBits(static_cast<float>(value)), 4);
+    } else {
+        append(uint8_t(0xcb));
+        appendBigEndian(doubleBits(value), 8);
+    }
+}
+
+void JsonBinaryWriter::writeMessagePackLength(size_t length, uint8_t fix, size_t fixLimit, uint8_t wide8, uint8_t wide16) {
+    if (length < fixLimit) {
+        append(static_cast<uint8_t>(fix | length));
+    } else if (wide8 != 0 && length <= 0xff) {
+        append(wide8);
+        appendBigEndian(length, 1);
+    } else if (length <= 0xffff) {
+        append(wide16);
+        appendBigEndian(length, 2);
+    } else if (length <= 0xffffffffu) {
+        append(static_cast<uint8_t>(wide16 + 1));
+        appendBigEndian(length, 4);
+    } else {
+        throw JsonException("Value too large for MessagePack: " + to_string(length) + " entries");
+    }
+}
+
+// ---- CBOR ----
+
+void JsonBinaryWriter::writeCbor(const Json& value) {
+    if (stream && staging.size() >= BUFFER_SIZE) flush();
+    switch (value.type) {
+        case Json::Type::Null:
+            append(uint8_t(0xf6));
+            break;
+
+        case Json::Type::Boolean:
+            append(uint8_t(get<bool>(value.value) ? 0xf5 : 0xf4));
+            break;
+
+        case Json::Type::Number:
+            if (auto i = get_if<int64_t>(&value.value)) {
+                // Negative integers are stored as -1 - n, which is ~n in two's complement
+                if (*i >= 0) writeCborHead(0, static_cast<uint64_t>(*i));
+                else writeCborHead(1, ~static_cast<uint64_t>(*i));
+            } else if (auto u = get_if<uint64_t>(&value.value)) {
+                writeCborHead(0, *u);
+            } else {
+                writeCborDouble(get<double>(value.value));
+            }
+            break;
+
+        case Json::Type::String: {
+            const auto& str = get<JsonString>(value.value);
+            writeCborHead(3, str.size());
+            append(str.data(), str.size());
+            break;
+        }
+
+        case Json::Type::Array: {
+            const auto& arr = get<Array>(value.value);
+            writeCborHead(4, arr.size());
+            for (const auto& element : arr) writeCbor(element);
+            break;
+        }
+
+        case Json::Type::Object: {
+            const auto& obj = get<Object>(value.value);
+            writeCborHead(5, obj.size());
+            for (const auto& [key, member] : obj) {
+                writeCborHead(3, key.size());
+                append(key.data(), key.size());
+                writeCbor(member);
+            }
+            break;
+        }
+    }
+}
+
+// Major type in the top three bits, then the argument in the shortest form that holds it
+void JsonBinaryWriter::writeCborHead(uint8_t major, uint64_t value) {
+    const uint8_t type = static_cast<uint8_t>(major << 5);
+    if (value < 24) {
+        append(static_cast<uint8_t>(type | value));
+    } else if (value <= 0xff) {
+        append(static_cast<uint8_t>(type | 24));
+        appendBigEndian(value, 1);
+    } else if (value <= 0xffff) {
+        append(static_cast<uint8_t>(type | 25));
+        appendBigEndian(value, 2);
+    } else if (value <= 0xffffffffu) {
+        append(static_cast<uint8_t>(type | 26));
+        appendBigEndian(value, 4);
+    } else {
+        append(static_cast<uint8_t>(type | 27));
+        appendBigEndian(value, 8);
+    }
+}
+
+void JsonBinaryWriter::writeCborDouble(double value) {
+    if (fitsFloat(value)) {
+        append(uint8_t(0xfa));
+        appendBigEndian(floatBits(static_cast<float>(value)), 4);
+    } else {
+        append(uint8_t(0xfb));
+        appendBigEndian(doubleBits(value), 8);
+    }
+}
+
+// ---- JsonBinaryReader ----
+
+JsonBinaryReader::JsonBinaryReader(std::string_view bytes, JsonBinaryFormat format) : input(bytes), format(format) {}
+
+JsonBinaryReader::JsonBinaryReader(std::istream& in, JsonBinaryFormat format) : stream(&in), format(format) {}
+
+Json JsonBinaryReader::read() {
+    return format == JsonBinaryFormat::MessagePack ? readMessagePack() : readCbor();
+}
+
+bool JsonBinaryReader::atEnd() {
+    return !fill(1);
+}
+
+void JsonBinaryReader::fail(const string& msg) const {
+    const char* name = format == JsonBinaryFormat::MessagePack ? "Invalid MessagePack: " : "Invalid CBOR: ";
+    throw JsonException(name + msg + " at byte " + to_string(offset()));
+}
+
+void JsonBinaryReader::need(size_t count) {
+    if (!fill(count)) fail("unexpected end of input");
+}
+
+// Make count bytes available from pos, reading more of a stream if need be. False if the
+// input ends first; a stream that fails throws
+bool JsonBinaryReader::fill(size_t count) {
+    if (count <= input.size() - pos) return true;
+    if (!stream) return false;
+
+    buffer.erase(0, pos);
+    base += pos;
+    pos = 0;
+    while (buffer.size() < count) {
+        const size_t used = buffer.size();
+        buffer.resize(used + CHUNK_SIZE);
+        stream->read(&buffer[used], static_cast<std::streamsize>(CHUNK_SIZE));
+        if (stream->bad()) throw JsonException("Error while reading input stream");
+        buffer.resize(used + static_cast<size_t>(stream->gcount()));
+        if (buffer.size() == used) break;
+    }
+    input = buffer;
+    return buffer.size() >= count;
+}
+
+uint8_t JsonBinaryReader::byte() {
+    need(1);
+    return static_cast<uint8_t>(input[pos++]);
+}
+
+uint64_t JsonBinaryReader::bigEndian(size_t count) {
+    need(count);
+    uint64_t value = 0;
+    for (size_t i = 0; i < count; ++i) {
+        value = (value << 8) | static_cast<uint8_t>(input[pos + i]);
+    }
+    pos += count;
+    return value;
+}
+
+// View of the next count bytes, valid until more input is needed
+std::string_view JsonBinaryReader::bytes(size_t count) {
+    need(count);
+    const std::string_view view = input.substr(pos, count);
+    pos += count;
+    return view;
+}
+
+// Capacity worth reserving for count entries. Every entry takes at least a byte, so a length
+// beyond the bytes at hand may be corrupt, and is not trusted past them; nor past
+// MAX_RESERVE, as each level of nesting reserves again from the same bytes
+size_t JsonBinaryReader::plausible(size_t count) const {
+    return std::min({count, input.size() - pos, MAX_RESERVE});
+}
+
+// ---- MessagePack ----
+
+Json JsonBinaryReader::readMessagePack() {
+    const uint8_t b = byte();
+    if (b <= 0x7f) return Json(static_cast<int64_t>(b));
+    if (b >= 0xe0) return Json(static_cast<int64_t>(static_cast<int8_t>(b)));
+    if (b <= 0x8f) return readMessagePackMap(b & 0x0f);
+    if (b <= 0x9f) return readMessagePackArray(b & 0x0f);
+    if (b <= 0xbf) return readMessagePackString(b & 0x1f);
+
+    switch (b) {
+        case 0xc0: return Json(nullptr);
+        case 0xc2: return Json(false);
+        case 0xc3: return Json(true);
+        case 0xc4: case 0xd9: return readMessagePackString(bigEndian(1));
+        case 0xc5: case 0xda: return readMessagePackString(bigEndian(2));
+        case 0xc6: case 0xdb: return readMessagePackString(bigEndian(4));
+        case 0xca: return Json(static_cast<double>(bitsFloat(static_cast<uint32_t>(bigEndian(4)))));
+        case 0xcb: return Json(bitsDouble(bigEndian(8)));
+        case 0xcc: return integer(bigEndian(1));
+        case 0xcd: return integer(bigEndian(2));
+        case 0xce: return integer(bigEndian(4));
+        case 0xcf: return integer(bigEndian(8));
+        case 0xd0: return Json(static_cast<int64_t>(static_cast<int8_t>(bigEndian(1))));
+        case 0xd1: return Json(static_cast<int64_t>(static_cast<int16_t>(bigEndian(2))));
+        case 0xd2: return Json(static_cast<int64_t>(static_cast<int32_t>(bigEndian(4))));
+        case 0xd3: return Json(static_cast<int64_t>(bigEndian(8)));
+        case 0xdc: return readMessagePackArray(bigEndian(2));
+        case 0xdd: return readMessagePackArray(bigEndian(4));
+        case 0xde: return readMessagePackMap(bigEndian(2));
+        case 0xdf: return readMessagePackMap(bigEndian(4));
+        case 0xc7: case 0xc8: case 0xc9:
+        case 0xd4: case 0xd5: case 0xd6: case 0xd7: case 0xd8:
+            --pos;
+            fail("extension types are not supported");
+        default:
+            --pos;
+            fail("unknown type byte " + to_string(b));
+    }
+}
+
+Json JsonBinaryReader::readMessagePackString(size_t length) {
+    const std::string_view text = bytes(length);
+    return Json(JsonString(text.data(), text.size()));
+}
+
+Json JsonBinaryReader::readMessagePackArray(size_t length) {
+    if (++depth > MAX_DEPTH) fail("nesting too deep");
+    Array arr;
+    arr.reserve(plausible(length));
+    for (size_t i = 0; i < length; ++i) arr.push_back(readMessagePack());
+    --depth;
+    return Json(std::move(arr));
+}
+
+Json JsonBinaryReader::readMessagePackMap(size_t length) {
+    if (++depth > MAX_DEPTH) fail("nesting too deep");
+    Json result = Json::object();
+    Object& obj = result.asObject();
+    obj.reserve(plausible(length));
+    for (size_t i = 0; i < length; ++i) {
+        const uint8_t b = byte();
+        size_t keyLength = 0;
+        if (b >= 0xa0 && b <= 0xbf) keyLength = b & 0x1f;
+        else if (b == 0xd9) keyLength = bigEndian(1);
+        else if (b == 0xda) keyLength = bigEndian(2);
+        else if (b == 0xdb) keyLength = bigEndian(4);
+        else {
+            --pos;
+            fail("map key is not a string");
+        }
+        // The key is copied out before the value is read, which may refill the buffer
+        JsonKey key(bytes(keyLength));
+        obj.insert_or_assign(std::move(key), readMessagePack());
+    }
+    --depth;
+    return result;
+}
+
+// ---- CBOR ----
+
+Json JsonBinaryReader::readCbor() {
+    uint8_t initial = byte();
+    // Tags are dropped, the value they wrap standing in for them. They are skipped here
+    // rather than by recursion, as a chain of them can be as long as the input
+    while ((initial >> 5) == 6) {
+        readCborArgument(initial & 0x1f);
+        initial = byte();
+    }
+    const uint8_t major = initial >> 5;
+    const uint8_t info = initial & 0x1f;
+
+    switch (major) {
+        case 0:
+            return integer(readCborArgument(info));
+        case 1: {
+            const uint64_t n = readCborArgument(info);
+            if (n <= static_cast<uint64_t>(numeric_limits<int64_t>::max())) return Json(-static_cast<int64_t>(n) - 1);
+            return Json(-1.0 - static_cast<double>(n));
+        }
+        case 2:
+        case 3:
+            return readCborString(major, info);
+        case 4:
+            return readCborArray(info);
+        case 5:
+            return readCborMap(info);
+        default:
+            break;
+    }
+
+    switch (info) {
+        case 20: return Json(false);
+        case 21: return Json(true);
+        case 22:
+        case 23: return Json(nullptr);
+        case 25: return Json(halfFloat(static_cast<uint16_t>(bigEndian(2))));
+        case 26: return Json(static_cast<double>(bitsFloat(static_cast<uint32_t>(bigEndian(4)))));
+        case 27: return Json(bitsDouble(bigEndian(8)));
+        case 31:
+            --pos;
+            fail("unexpected break");
+        default:
+            --pos;
+            fail("unsupported simple value " + to_string(info));
+    }
+}
+
+uint64_t JsonBinaryReader::readCborArgument(uint8_t info) {
+    if (info < 24) return info;
+    switch (info) {
+        case 24: return bigEndian(1);
+        case 25: return bigEndian(2);
+        case 26: return bigEndian(4);
+        case 27: return bigEndian(8);
+        default:
+            --pos;
+            fail("invalid length or argument");
+    }
+}
+
+Json JsonBinaryReader::readCborString(uint8_t major, uint8_t info) {
+    if (info != 31) {
+        const std::string_view text = bytes(readCborArgument(info));
+        return Json(JsonString(text.data(), text.size()));
+    }
+
+    // Indefinite length: definite-length chunks of the same major type, up to a break
+    JsonString text;
+    while (true) {
+        const uint8_t initial = byte();
+        if (initial == 0xff) break;
+        if ((initial >> 5) != major || (initial & 0x1f) == 31) {
+            --pos;
+            fail("invalid chunk in indefinite-length string");
+        }
+        const std::string_view chunk = bytes(readCborArgument(initial & 0x1f));
+        text.append(chunk.data(), chunk.size());
+    }
+    return Json(std::move(text));
+}
+
+Json JsonBinaryReader::readCborArray(uint8_t info) {
+    if (++depth > MAX_DEPTH) fail("nesting too deep");
+    Array arr;
+    if (info == 31) {
+        while (true) {
+            need(1);
+            if (static_cast<uint8_t>(input[pos]) == 0xff) break;
+            arr.push_back(readCbor());
+        }
+        ++pos;
+    } else {
+        const uint64_t length = readCborArgument(info);
+        arr.reserve(plausible(length));
+        for (uint64_t i = 0; i < length; ++i) arr.push_back(readCbor());
+    }
+    --depth;
+    return Json(std::move(arr));
+}
+
+Json JsonBinaryReader::readCborMap(uint8_t info) {
+    if (++depth > MAX_DEPTH) fail("nesting too deep");
+    Json result = Json::object();
+    Object& obj = result.asObject();
+    const bool indefinite = info == 31;
+    const uint64_t length = indefinite ? 0 : readCborArgument(info);
+    if (!indefinite) obj.reserve(plausible(length));
+
+    for (uint64_t i = 0; indefinite || i < length; ++i) {
+        const uint8_t initial = byte();
+        if (indefinite && initial == 0xff) break;
+        if ((initial >> 5) != 3) {
+            --pos;
+            fail("map key is not a text string");
+        }
+        JsonKey key((initial & 0x1f) == 31
+            ? readCborString(3, 31).asString()
+            : bytes(readCborArgument(initial & 0x1f)));
+        obj.insert_or_assign(std::move(key), readCbor());
+    }
+    --depth;
+    return result;
+}
+
+}
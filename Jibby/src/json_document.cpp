@@ -0,0 +1,62 @@
+#include "json_document.h"
+#include "json_parser.h"
+
+using namespace std;
+
+namespace jibby {
+
+void* JsonDocument::CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    allocated += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void JsonDocument::CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+bool JsonDocument::CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+JsonDocument::JsonDocument(size_t initialCapacity, size_t maxKeys)
+    : block(new std::byte[initialCapacity]), blockSize(initialCapacity), keys(std::pmr::new_delete_resource()),
+      maxKeys(maxKeys) {
+    arena.emplace(block.get(), blockSize, &upstream);
+}
+
+Json& JsonDocument::parse(std::string_view jsonText) {
+    clear();
+    rootValue = JsonParser(jsonText, resource(), keys).parse();
+    return rootValue;
+}
+
+void JsonDocument::clear() {
+    // Node destructors still run, but deallocating from a monotonic arena is a no-op
+    rootValue = Json();
+    // Nothing refers to the keys any more
+    if (keys.size() > maxKeys) keys.clear();
+
+    const size_t used = arenaSize();
+    arena.reset();
+    upstream.allocated = 0;
+    if (used > blockSize) {
+        block.reset(new std::byte[used]);
+        blockSize = used;
+    }
+    arena.emplace(block.get(), blockSize, &upstream);
+}
+
+void JsonDocument::clearKeys() {
+    clear();
+    keys.clear();
+}
+
+std::pmr::memory_resource* JsonDocument::resource() {
+    return &*arena;
+}
+
+size_t JsonDocument::arenaSize() const {
+    return blockSize + upstream.allocated;
+}
+
+}
@@ -0,0 +1,96 @@
+#include "json_dom_builder.h"
+
+using namespace std;
+
+namespace jibby {
+
+JsonDomBuilder::JsonDomBuilder(std::pmr::memory_resource* resource, JsonKeyPool* keys)
+    : resource(resource), keys(keys) {}
+
+// ---- Containers ----
+JsonHandler::Action JsonDomBuilder::startObject() {
+    starts.push_back(values.size());
+    return Action::Continue;
+}
+
+JsonHandler::Action JsonDomBuilder::key(std::string_view name) {
+    names.push_back(keys ? keys->intern(name) : JsonKey(name, resource));
+    return Action::Continue;
+}
+
+JsonHandler::Action JsonDomBuilder::endObject() {
+    const size_t start = starts.back();
+    const size_t count = values.size() - start;
+    const size_t firstName = names.size() - count;
+    starts.pop_back();
+
+    Object obj(resource);
+    obj.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        obj.insert_or_assign(std::move(names[firstName + i]), std::move(values[start + i]));
+    }
+    names.resize(firstName);
+    values.resize(start);
+    values.emplace_back(std::move(obj));
+    return Action::Continue;
+}
+
+JsonHandler::Action JsonDomBuilder::startArray() {
+    starts.push_back(values.size());
+    return Action::Continue;
+}
+
+JsonHandler::Action JsonDomBuilder::endArray() {
+    const size_t start = starts.back();
+    starts.pop_back();
+
+    Array arr(resource);
+    arr.reserve(values.size() - start);
+    for (size_t i = start; i < values.size(); ++i) {
+        arr.push_back(std::move(values[i]));
+    }
+    values.resize(start);
+    values.emplace_back(std::move(arr));
+    return Action::Continue;
+}
+
+// ---- Scalars ----
+JsonHandler::Action JsonDomBuilder::string(std::string_view value) {
+    values.emplace_back(JsonString(value, resource));
+    return Action::Continue;
+}
+
+JsonHandler::Action JsonDomBuilder::boolean(bool value) {
+    values.emplace_back(value);
+    return Action::Continue;
+}
+
+JsonHandler::Action JsonDomBuilder::null() {
+    values.emplace_back(nullptr);
+    return Action::Continue;
+}
+
+JsonHandler::Action JsonDomBuilder::number(double value) {
+    values.emplace_back(value);
+    return Action::Continue;
+}
+
+JsonHandler::Action JsonDomBuilder::int64(int64_t value) {
+    values.emplace_back(value);
+    return Action::Continue;
+}
+
+JsonHandler::Action JsonDomBuilder::uint64(uint64_t value) {
+    values.emplace_back(value);
+    return Action::Continue;
+}
+
+Json JsonDomBuilder::result() {
+    Json value = values.empty() ? Json() : std::move(values.back());
+    values.clear();
+    names.clear();
+    starts.clear();
+    return value;
+}
+
+}
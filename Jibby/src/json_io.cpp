@@ -1,28 +1,71 @@
 #include "json_io.h"
 #include "json_exception.h"
+#include "json_mapped_file.h"
 #include "json_parser.h"
+#include "json_writer.h"
+#include <algorithm>
+#include <deque>
 #include <fstream>
-#include <sstream>
+#include <memory>
 
 namespace jibby {
+
+    namespace {
+
+    // Parse a whole file in place, mapped or read as JsonMappedFile decides
+    Json parseFile(const string& filepath, size_t minMappedSize) {
+        JsonMappedFile file(filepath, minMappedSize);
+        try{
+            return JsonParser(file.text()).parse();
+        } catch (const JsonException&) {
+            throw;
+        } catch (const std::exception& e) {
+            throw JsonException("Error while parsing file: " + filepath + " | " + e.what());
+        }
+    }
+
+    // Pool for readManyAsync() calls given none, whose tasks outlive the call
+    JsonWorkerPool& sharedPool() {
+        static JsonWorkerPool pool;
+        return pool;
+    }
+
+    } // namespace
+
     // Read in a json file from source: filepath
     Json JsonIO::read(const string& filepath) {
-        std::ifstream file(filepath);
+        // Where files can be mapped, large ones are, however large: the mapping is paged in as
+        // the parser reaches it rather than copied. JsonMappedFile reads small files and anything
+        // without a size, such as a pipe
+        if (JsonMappedFile::supported()) return parseFile(filepath, JsonReadOptions::MAP_THRESHOLD);
+
+        std::ifstream file(filepath, std::ios::binary);
         // Check file is open, if not throw an error message
         if (!file.is_open()) {
             throw JsonException("Failed to open file for reading: " + filepath);
         }
 
-        // create a stream variable to hold the entire string from the json file
-        std::stringstream buffer;
-        // read and assign the file contents to the buffer variable
-        buffer << file.rdbuf();
-        // close the file
-        file.close();
-        
-        // parse the json buffer. Throw error if encountered
+        // Large files are parsed from the stream a chunk at a time; anything else is read
+        // straight into a single string sized up front
+        string buffer;
+        file.seekg(0, std::ios::end);
+        std::streamoff size = file.tellg();
+        file.seekg(0, std::ios::beg);
+        const bool streaming = size >= static_cast<std::streamoff>(STREAMING_THRESHOLD);
+        if (!streaming) {
+            if (size > 0) {
+                buffer.resize(static_cast<size_t>(size));
+                file.read(&buffer[0], size);
+                buffer.resize(static_cast<size_t>(file.gcount()));
+            }
+            // close the file
+            file.close();
+        }
+
+        // parse the json buffer, handing it over to the parser. Throw error if encountered
         try{
-            JsonParser parser(buffer.str());
+            if (streaming) return read(file);
+            JsonParser parser(std::move(buffer));
             return parser.parse();
         } catch (const JsonException&) {
             throw;
@@ -31,6 +74,123 @@ namespace jibby {
         }
     }
 
+    // Parse a json file in place from a read-only mapping of it
+    Json JsonIO::readMapped(const string& filepath) {
+        return parseFile(filepath, 0);
+    }
+
+    // Read json from a stream without loading it whole
+    Json JsonIO::read(std::istream& in) {
+        return JsonParser(in).parse();
+    }
+
+    // Read a file of records, parsed in batches on a worker pool
+    bool JsonIO::readLines(const string& filepath, const JsonLinesReader::RecordCallback& onRecord,
+                           JsonLinesReader::Format format) {
+        JsonMappedFile file(filepath);
+        return JsonLinesReader(file.text(), format).forEach(onRecord);
+    }
+
+    // Read many files, collecting every result
+    vector<JsonFileResult> JsonIO::readMany(const vector<string>& paths, const JsonReadOptions& options) {
+        vector<JsonFileResult> results(paths.size());
+        readMany(paths, [&results](size_t index, JsonFileResult& result) {
+            results[index] = std::move(result);
+            return true;
+        }, options);
+        return results;
+    }
+
+    // Read many files on a pool, FILES_PER_TASK to a task, delivering them in order as they complete
+    bool JsonIO::readMany(const vector<string>& paths, const FileCallback& onFile, const JsonReadOptions& options) {
+        std::unique_ptr<JsonWorkerPool> ownPool;
+        JsonWorkerPool* pool = options.pool;
+        if (pool == nullptr) {
+            ownPool = std::make_unique<JsonWorkerPool>();
+            pool = ownPool.get();
+        }
+
+        // Consecutive files handed to one task, and what it made of them
+        struct Batch {
+            vector<JsonFileResult> results;
+            std::future<void> done;
+        };
+        // Tasks refer to their batch, so none may still be running once this returns or throws
+        std::deque<Batch> batches;
+        struct Drain {
+            std::deque<Batch>& batches;
+            ~Drain() {
+                for (auto& batch : batches) {
+                    if (batch.done.valid()) batch.done.wait();
+                }
+            }
+        } drain{batches};
+
+        // Files may wait on the disk rather than the CPU, so more are kept in flight than there
+        // are threads
+        const size_t window = 4 * pool->size();
+        const size_t mapThreshold = options.mapThreshold;
+        size_t submitted = 0;
+        size_t delivered = 0;
+        while (delivered < paths.size()) {
+            while (submitted < paths.size() && batches.size() < window) {
+                Batch& batch = batches.emplace_back();
+                const size_t first = submitted;
+                submitted = std::min(paths.size(), submitted + FILES_PER_TASK);
+                batch.results.resize(submitted - first);
+                batch.done = pool->submit([&paths, first, mapThreshold, &batch] {
+                    for (size_t i = 0; i < batch.results.size(); ++i) {
+                        try {
+                            batch.results[i].value = parseFile(paths[first + i], mapThreshold);
+                        } catch (...) {
+                            batch.results[i].error = std::current_exception();
+                        }
+                    }
+                });
+            }
+            Batch& batch = batches.front();
+            batch.done.get();
+            for (JsonFileResult& result : batch.results) {
+                if (!onFile(delivered++, result)) return false;
+            }
+            batches.pop_front();
+        }
+        return true;
+    }
+
+    // Queue every file, FILES_PER_TASK to a task, each task settling the promises of its files
+    vector<std::future<Json>> JsonIO::readManyAsync(const vector<string>& paths, const JsonReadOptions& options) {
+        JsonWorkerPool& pool = options.pool != nullptr ? *options.pool : sharedPool();
+        const size_t mapThreshold = options.mapThreshold;
+
+        // std::function needs a copyable task, so the group is shared with it
+        struct Group {
+            vector<string> paths;
+            vector<std::promise<Json>> promises;
+        };
+
+        vector<std::future<Json>> futures;
+        futures.reserve(paths.size());
+        for (size_t first = 0; first < paths.size(); first += FILES_PER_TASK) {
+            const size_t last = std::min(paths.size(), first + FILES_PER_TASK);
+            auto group = std::make_shared<Group>();
+            group->paths.assign(paths.begin() + static_cast<std::ptrdiff_t>(first),
+                                paths.begin() + static_cast<std::ptrdiff_t>(last));
+            group->promises.resize(last - first);
+            for (auto& promise : group->promises) futures.push_back(promise.get_future());
+            pool.submit([group, mapThreshold] {
+                for (size_t i = 0; i < group->paths.size(); ++i) {
+                    try {
+                        group->promises[i].set_value(parseFile(group->paths[i], mapThreshold));
+                    } catch (...) {
+                        group->promises[i].set_exception(std::current_exception());
+                    }
+                }
+            });
+        }
+        return futures;
+    }
+
     // Write to a json file, include prettifying the structure if desired
     void JsonIO::write(const Json& json, const string& filepath, bool pretty) {
         // Output file stream object using the desired filepath
@@ -40,8 +200,8 @@ namespace jibby {
             throw JsonException("Failed to open file for writing: " + filepath);
         }
 
-        // Write the serialized json object to the file (4 is yes, 0 is no) 
-        file << json.serialize(pretty ? 4 : 0);
+        // Stream the serialized json object to the file (4 is yes, 0 is no) 
+        JsonWriter(file).write(json, pretty ? 4 : 0);
         // Close the file
         file.close();
 
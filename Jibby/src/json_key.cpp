@@ -0,0 +1,155 @@
+#include "json_key.h"
+#include <cstring>
+
+using namespace std;
+
+namespace jibby {
+
+namespace {
+
+// Text of every empty key, so they never allocate
+constexpr char EMPTY_TEXT[] = "";
+
+uint32_t emptyHash() {
+    static const uint32_t hash = JsonKey::hashText({});
+    return hash;
+}
+
+} // namespace
+
+uint32_t JsonKey::hashText(std::string_view key) {
+    // Eight bytes per step with 64-bit mixing, folded to 32 bits
+    uint64_t hash = 0x9E3779B97F4A7C15ULL ^ key.size();
+    const char* data = key.data();
+    size_t remaining = key.size();
+    while (remaining >= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        hash = (hash ^ word) * 0xBF58476D1CE4E5B9ULL;
+        hash ^= hash >> 31;
+        data += 8;
+        remaining -= 8;
+    }
+    uint64_t tail = 0;
+    if (remaining > 0) std::memcpy(&tail, data, remaining);
+    hash = (hash ^ tail) * 0x94D049BB133111EBULL;
+    hash ^= hash >> 32;
+    return static_cast<uint32_t>(hash);
+}
+
+// ---- Constructors ----
+JsonKey::JsonKey(const allocator_type& alloc) noexcept
+    : text(EMPTY_TEXT), keyHash(emptyHash()), resource(alloc.resource()) {}
+
+JsonKey::JsonKey(std::string_view value, const allocator_type& alloc)
+    : text(EMPTY_TEXT), resource(alloc.resource()) {
+    assign(value);
+}
+
+JsonKey::JsonKey(const JsonKey& other)
+    : text(EMPTY_TEXT), keyHash(emptyHash()), resource(other.resource) {
+    *this = other;
+}
+
+JsonKey::JsonKey(const JsonKey& other, const allocator_type& alloc)
+    : text(EMPTY_TEXT), resource(alloc.resource()) {
+    assign(other);
+}
+
+JsonKey::JsonKey(JsonKey&& other) noexcept
+    : text(other.text), length(other.length), keyHash(other.keyHash), pooled(other.pooled),
+      resource(other.resource) {
+    if (other.text == other.local) {
+        std::memcpy(local, other.local, length);
+        text = local;
+    }
+    other.text = EMPTY_TEXT;
+    other.length = 0;
+    other.keyHash = emptyHash();
+    other.pooled = false;
+}
+
+JsonKey::JsonKey(JsonKey&& other, const allocator_type& alloc)
+    : text(EMPTY_TEXT), resource(alloc.resource()) {
+    *this = std::move(other);
+}
+
+JsonKey JsonKey::interned(std::string_view value, uint32_t hash) noexcept {
+    JsonKey key;
+    key.text = value.data();
+    key.length = value.size();
+    key.keyHash = hash;
+    key.pooled = true;
+    return key;
+}
+
+JsonKey::~JsonKey() {
+    release();
+}
+
+// ---- Assignment ----
+JsonKey& JsonKey::operator=(const JsonKey& other) {
+    if (this == &other) return *this;
+    if (other.pooled) {
+        release();
+        text = other.text;
+        length = other.length;
+        keyHash = other.keyHash;
+        pooled = true;
+    } else {
+        assign(other);
+    }
+    return *this;
+}
+
+JsonKey& JsonKey::operator=(JsonKey&& other) {
+    if (this == &other) return *this;
+    // Owned text can only change hands within one resource
+    if (!other.pooled && !resource->is_equal(*other.resource)) {
+        assign(other);
+        return *this;
+    }
+    release();
+    text = other.text;
+    length = other.length;
+    keyHash = other.keyHash;
+    pooled = other.pooled;
+    if (other.text == other.local) {
+        std::memcpy(local, other.local, length);
+        text = local;
+    }
+    other.text = EMPTY_TEXT;
+    other.length = 0;
+    other.keyHash = emptyHash();
+    other.pooled = false;
+    return *this;
+}
+
+// ---- Storage ----
+// value may be this key's own text, so it is copied before the old text is released
+void JsonKey::assign(std::string_view value) {
+    const uint32_t hash = hashText(value);
+    if (value.size() <= INLINE_CAPACITY) {
+        char copy[INLINE_CAPACITY];
+        std::memcpy(copy, value.data(), value.size());
+        release();
+        std::memcpy(local, copy, value.size());
+        text = value.empty() ? EMPTY_TEXT : local;
+    } else {
+        char* buffer = static_cast<char*>(resource->allocate(value.size(), alignof(char)));
+        std::memcpy(buffer, value.data(), value.size());
+        release();
+        text = buffer;
+    }
+    length = value.size();
+    keyHash = hash;
+    pooled = false;
+}
+
+void JsonKey::release() {
+    if (!pooled && length > 0 && text != local) resource->deallocate(const_cast<char*>(text), length, alignof(char));
+    text = EMPTY_TEXT;
+    length = 0;
+}
+
+}
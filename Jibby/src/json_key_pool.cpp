@@ -0,0 +1,62 @@
+#include "json_key_pool.h"
+#include <cstring>
+
+using namespace std;
+
+namespace jibby {
+
+namespace {
+
+constexpr size_t INITIAL_SLOTS = 64;
+
+} // namespace
+
+JsonKeyPool::JsonKeyPool(std::pmr::memory_resource* upstream)
+    : storage(upstream), keys(upstream), slots(INITIAL_SLOTS, 0, upstream) {}
+
+JsonKey JsonKeyPool::intern(std::string_view text) {
+    const uint32_t hash = JsonKey::hashText(text);
+    size_t mask = slots.size() - 1;
+    size_t slot = hash & mask;
+    for (; slots[slot] != 0; slot = (slot + 1) & mask) {
+        const JsonKey& key = keys[slots[slot] - 1];
+        if (key.hash() == hash && key == text) return key;
+    }
+
+    // Keep the index at most half full
+    if ((keys.size() + 1) * 2 > slots.size()) {
+        grow();
+        mask = slots.size() - 1;
+        slot = hash & mask;
+        while (slots[slot] != 0) slot = (slot + 1) & mask;
+    }
+
+    const char* copy = "";
+    if (!text.empty()) {
+        char* buffer = static_cast<char*>(storage.allocate(text.size(), alignof(char)));
+        std::memcpy(buffer, text.data(), text.size());
+        copy = buffer;
+    }
+    keys.push_back(JsonKey::interned(std::string_view(copy, text.size()), hash));
+    slots[slot] = static_cast<uint32_t>(keys.size());
+    return keys.back();
+}
+
+void JsonKeyPool::grow() {
+    std::pmr::vector<uint32_t> next(slots.size() * 2, 0, slots.get_allocator());
+    const size_t mask = next.size() - 1;
+    for (size_t pos = 0; pos < keys.size(); ++pos) {
+        size_t slot = keys[pos].hash() & mask;
+        while (next[slot] != 0) slot = (slot + 1) & mask;
+        next[slot] = static_cast<uint32_t>(pos + 1);
+    }
+    slots.swap(next);
+}
+
+void JsonKeyPool::clear() {
+    keys.clear();
+    slots.assign(INITIAL_SLOTS, 0);
+    storage.release();
+}
+
+}
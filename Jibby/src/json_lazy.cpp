@@ -0,0 +1,189 @@
+#include "json_lazy.h"
+#include "json_parser.h"
+#include "json_scanner.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace jibby {
+
+// ---- JsonLazyValue ----
+
+char JsonLazyValue::first() const {
+    return document->text[offset];
+}
+
+std::string_view JsonLazyValue::raw() const {
+    return document->text.substr(offset, length);
+}
+
+size_t JsonLazyValue::size() const {
+    if (!isObject() && !isArray()) throw JsonException("Json value is not an object or array");
+    return document->entries(offset).size();
+}
+
+bool JsonLazyValue::contains(std::string_view key) const {
+    if (!isObject()) return false;
+    const uint32_t hash = JsonKey::hashText(key);
+    for (const auto& entry : document->entries(offset)) {
+        if (entry.keyHash == hash && entry.key == key) return true;
+    }
+    return false;
+}
+
+JsonLazyValue JsonLazyValue::operator[](std::string_view key) const {
+    if (!isObject()) throw JsonException("Cannot use operator[] on non-object JSON value");
+    const auto& members = document->entries(offset);
+    const uint32_t hash = JsonKey::hashText(key);
+    for (auto it = members.rbegin(); it != members.rend(); ++it) {
+        if (it->keyHash == hash && it->key == key) return JsonLazyValue(document, it->offset, it->length);
+    }
+    throw JsonException("Key not found: " + string(key));
+}
+
+JsonLazyValue JsonLazyValue::operator[](size_t index) const {
+    if (!isArray()) throw JsonException("Cannot use operator[] with index on non-array JSON value");
+    const auto& elements = document->entries(offset);
+    if (index >= elements.size()) throw JsonException("Array index out of bounds: " + to_string(index));
+    return JsonLazyValue(document, elements[index].offset, elements[index].length);
+}
+
+std::string_view JsonLazyValue::asString() const {
+    if (!isString()) throw JsonException("Json value is not a string");
+    return json().asString();
+}
+
+double JsonLazyValue::asNumber() const {
+    if (!isNumber()) throw JsonException("Json value is not a number");
+    return json().asNumber();
+}
+
+int64_t JsonLazyValue::asInt64() const {
+    if (!isNumber()) throw JsonException("Json value is not an int64 number");
+    return json().asInt64();
+}
+
+uint64_t JsonLazyValue::asUInt64() const {
+    if (!isNumber()) throw JsonException("Json value is not a uint64 number");
+    return json().asUInt64();
+}
+
+bool JsonLazyValue::asBoolean() const {
+    if (!isBoolean()) throw JsonException("Json value is not a boolean");
+    return first() == 't';
+}
+
+const Json& JsonLazyValue::json() const {
+    return document->value(offset, length);
+}
+
+JsonLazyValue::Iterator JsonLazyValue::begin() const {
+    if (!isObject() && !isArray()) throw JsonException("Cannot iterate over non-object/array JSON value");
+    return Iterator(document, offset, 0);
+}
+
+JsonLazyValue::Iterator JsonLazyValue::end() const {
+    return Iterator(document, offset, size());
+}
+
+std::pair<std::string_view, JsonLazyValue> JsonLazyValue::Iterator::operator*() const {
+    const auto& entry = document->entries(offset)[position];
+    return {entry.key, JsonLazyValue(document, entry.offset, entry.length)};
+}
+
+// ---- JsonLazyDocument ----
+
+JsonLazyDocument::JsonLazyDocument(std::string_view jsonText) : text(jsonText) {
+    validate();
+}
+
+JsonLazyDocument::JsonLazyDocument(const char* jsonText)
+    : JsonLazyDocument(std::string_view(jsonText)) {}
+
+JsonLazyDocument::JsonLazyDocument(string&& jsonText) : owned(std::move(jsonText)), text(owned) {
+    validate();
+}
+
+JsonLazyDocument::JsonLazyDocument(JsonMappedFile&& mapped) : file(std::move(mapped)), text(file->text()) {
+    validate();
+}
+
+void JsonLazyDocument::validate() {
+    JsonParser(text).validate(&containers);
+}
+
+JsonLazyValue JsonLazyDocument::root() const {
+    const size_t offset = JsonScanner::skipWhitespace(text, 0);
+    return JsonLazyValue(this, offset, valueEnd(offset) - offset);
+}
+
+size_t JsonLazyDocument::materializedCount() const {
+    return static_cast<size_t>(std::count_if(nodes.begin(), nodes.end(), [](const auto& node) {
+        return node.second.value.has_value();
+    }));
+}
+
+// Offset just past the closing quote of the string starting at offset
+size_t JsonLazyDocument::stringEnd(size_t offset) const {
+    size_t pos = offset + 1;
+    while (true) {
+        pos = JsonScanner::findStringSpecial(text, pos);
+        if (text[pos] == '"') return pos + 1;
+        // The text has been validated, so a backslash always starts a complete escape
+        pos += text[pos] == '\\' ? 2 : 1;
+    }
+}
+
+// Offset just past the value starting at offset
+size_t JsonLazyDocument::valueEnd(size_t offset) const {
+    const char c = text[offset];
+    if (c == '{' || c == '[') {
+        const auto span = std::lower_bound(containers.begin(), containers.end(), std::make_pair(offset, size_t(0)));
+        return span->second + 1;
+    }
+    if (c == '"') return stringEnd(offset);
+    size_t pos = offset;
+    while (pos < text.size() && !JsonScanner::isWhitespace(text[pos]) && !JsonScanner::isStructural(text[pos])) ++pos;
+    return pos;
+}
+
+// Children of the container at offset, found on first use by stepping from one to the next
+const vector<JsonLazyDocument::Entry>& JsonLazyDocument::entries(size_t offset) const {
+    Node& node = nodes[offset];
+    if (node.indexed) return node.entries;
+
+    const bool object = text[offset] == '{';
+    const size_t close = valueEnd(offset) - 1;
+    size_t pos = JsonScanner::skipWhitespace(text, offset + 1);
+    while (pos < close) {
+        Entry entry{std::string_view(), 0, 0, 0};
+        if (object) {
+            const size_t keyEnd = stringEnd(pos);
+            entry.key = text.substr(pos + 1, keyEnd - pos - 2);
+            if (entry.key.find('\\') != std::string_view::npos) {
+                decodedKeys.emplace_back(JsonParser(text, pos, keyEnd).parse().asString());
+                entry.key = decodedKeys.back();
+            }
+            entry.keyHash = JsonKey::hashText(entry.key);
+            // Step over the colon
+            pos = JsonScanner::skipWhitespace(text, JsonScanner::skipWhitespace(text, keyEnd) + 1);
+        }
+        const size_t end = valueEnd(pos);
+        entry.offset = pos;
+        entry.length = end - pos;
+        node.entries.push_back(entry);
+
+        pos = JsonScanner::skipWhitespace(text, end);
+        if (text[pos] == ',') pos = JsonScanner::skipWhitespace(text, pos + 1);
+    }
+    node.indexed = true;
+    return node.entries;
+}
+
+const Json& JsonLazyDocument::value(size_t offset, size_t length) const {
+    Node& node = nodes[offset];
+    if (!node.value) node.value = JsonParser(text, offset, offset + length).parse();
+    return *node.value;
+}
+
+}
@@ -0,0 +1,215 @@
+#include "json_lines_reader.h"
+#include "json_parser.h"
+#include <cstring>
+#include <deque>
+#include <utility>
+
+using namespace std;
+
+namespace jibby {
+
+namespace {
+
+// Records handed to one task, and what it made of them
+struct Batch {
+    vector<std::pair<size_t, size_t>> ranges;               // [begin, end) of each record
+    vector<Json> records;
+    vector<std::pair<size_t, JsonParseException>> failures; // position in the batch, in order
+    std::future<void> done;
+};
+
+void parseBatch(std::string_view text, Batch& batch) {
+    batch.records.resize(batch.ranges.size());
+    for (size_t i = 0; i < batch.ranges.size(); ++i) {
+        try {
+            JsonParser parser(text, batch.ranges[i].first, batch.ranges[i].second);
+            batch.records[i] = parser.parse();
+        } catch (const JsonParseException& error) {
+            batch.failures.emplace_back(i, error);
+        }
+    }
+}
+
+} // namespace
+
+JsonLinesReader::JsonLinesReader(std::string_view text, Format format, JsonWorkerPool* pool)
+    : text(text), format(format), pool(pool), scanner(text) {
+    if (this->pool == nullptr) {
+        ownPool = std::make_unique<JsonWorkerPool>();
+        this->pool = ownPool.get();
+    }
+}
+
+bool JsonLinesReader::forEach(const RecordCallback& onRecord) {
+    return forEach(onRecord, [](size_t, const JsonParseException& error) -> bool { throw error; });
+}
+
+bool JsonLinesReader::forEach(const RecordCallback& onRecord, const ErrorCallback& onError) {
+    pos = 0;
+    scanner = JsonScanner(text);
+    index.clear();
+    cursor = 0;
+    opened = false;
+    separated = false;
+    finished = false;
+
+    // Tasks refer to their batch, so none may still be running once this returns or throws
+    std::deque<Batch> batches;
+    struct Drain {
+        std::deque<Batch>& batches;
+        ~Drain() {
+            for (auto& batch : batches) {
+                if (batch.done.valid()) batch.done.wait();
+            }
+        }
+    } drain{batches};
+
+    // Enough batches in flight to keep every thread busy while the oldest is delivered
+    const size_t window = 2 * pool->size();
+    size_t delivered = 0;
+    bool more = true;
+    while (true) {
+        while (more && batches.size() < window) {
+            Batch& batch = batches.emplace_back();
+            size_t bytes = 0;
+            size_t begin = 0;
+            size_t end = 0;
+            while (bytes < BATCH_SIZE && (more = nextRecord(begin, end))) {
+                batch.ranges.emplace_back(begin, end);
+                bytes += end - begin;
+            }
+            if (batch.ranges.empty()) {
+                batches.pop_back();
+                break;
+            }
+            const std::string_view input = text;
+            batch.done = pool->submit([input, &batch] { parseBatch(input, batch); });
+        }
+        if (batches.empty()) return true;
+
+        Batch& batch = batches.front();
+        batch.done.get();
+        size_t failure = 0;
+        for (size_t i = 0; i < batch.records.size(); ++i, ++delivered) {
+            if (failure < batch.failures.size() && batch.failures[failure].first == i) {
+                if (!onError(delivered, batch.failures[failure++].second)) return false;
+            } else if (!onRecord(delivered, batch.records[i])) {
+                return false;
+            }
+        }
+        batches.pop_front();
+    }
+}
+
+bool JsonLinesReader::nextRecord(size_t& begin, size_t& end) {
+    switch (format) {
+        case Format::Lines: return nextLine(begin, end);
+        case Format::Concatenated: return nextValue(begin, end);
+        case Format::Elements: return nextElement(begin, end);
+    }
+    return false;
+}
+
+// Next line holding anything but whitespace
+bool JsonLinesReader::nextLine(size_t& begin, size_t& end) {
+    while (pos < text.size()) {
+        const void* newline = std::memchr(text.data() + pos, '\n', text.size() - pos);
+        begin = pos;
+        end = newline != nullptr ? static_cast<size_t>(static_cast<const char*>(newline) - text.data()) : text.size();
+        pos = end + 1;
+        if (JsonScanner::skipWhitespace(text.substr(0, end), begin) < end) return true;
+    }
+    return false;
+}
+
+// Next top-level value, found by matching brackets in the structural index. Malformed input
+// still yields a record, so the parser reports the error at its place
+bool JsonLinesReader::nextValue(size_t& begin, size_t& end) {
+    if (!peekIndexed(begin)) return false;
+    ++cursor;
+    const char first = text[begin];
+    if (first != '{' && first != '[') {
+        // A scalar runs up to the next token. A stray ',', ':', '}' or ']' is a record by itself
+        if (JsonScanner::isStructural(first)) {
+            end = begin + 1;
+        } else if (!peekIndexed(end)) {
+            end = text.size();
+        }
+        return true;
+    }
+
+    size_t depth = 1;
+    size_t offset = 0;
+    while (peekIndexed(offset)) {
+        ++cursor;
+        const char c = text[offset];
+        if (c == '{' || c == '[') {
+            ++depth;
+        } else if ((c == '}' || c == ']') && --depth == 0) {
+            end = offset + 1;
+            return true;
+        }
+    }
+    end = text.size();
+    return true;
+}
+
+// Next element of the top-level array, split at the commas directly inside it. Anything the
+// split cannot vouch for, such as an unclosed array or text after it, makes the whole text the
+// final record, so the parser reports it exactly as it would for a single document
+bool JsonLinesReader::nextElement(size_t& begin, size_t& end) {
+    if (finished) return false;
+    size_t offset = 0;
+    if (!opened) {
+        if (!peekIndexed(offset)) return false;
+        if (text[offset] != '[') {
+            finished = true;
+            begin = 0;
+            end = text.size();
+            return true;
+        }
+        ++cursor;
+        opened = true;
+        pos = offset + 1;
+    }
+
+    size_t depth = 0;
+    while (peekIndexed(offset)) {
+        ++cursor;
+        const char c = text[offset];
+        if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            if (depth-- > 0) continue;
+            finished = true;
+            size_t trailing = 0;
+            if (c != ']' || peekIndexed(trailing)) break;
+            begin = pos;
+            end = offset;
+            // [] has no elements, but [1,] has an empty one for the parser to reject
+            return separated || JsonScanner::skipWhitespace(text.substr(0, end), begin) < end;
+        } else if (c == ',' && depth == 0) {
+            separated = true;
+            begin = pos;
+            end = offset;
+            pos = offset + 1;
+            return true;
+        }
+    }
+    finished = true;
+    begin = 0;
+    end = text.size();
+    return true;
+}
+
+// Offset of the next indexed token, without moving past it
+bool JsonLinesReader::peekIndexed(size_t& offset) {
+    while (cursor == index.size()) {
+        if (!scanner.nextWindow(index)) return false;
+        cursor = 0;
+    }
+    offset = index[cursor];
+    return true;
+}
+
+}
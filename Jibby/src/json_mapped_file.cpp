@@ -0,0 +1,131 @@
+#include "json_mapped_file.h"
+#include "json_exception.h"
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define JIBBY_HAVE_MMAP 1
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace jibby {
+
+namespace {
+
+// Portable path: the whole file in one read into a string sized up front
+void readWhole(const string& filepath, string& out) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        throw JsonException("Failed to open file for reading: " + filepath);
+    }
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (size > 0) {
+        out.resize(static_cast<size_t>(size));
+        file.read(&out[0], size);
+        out.resize(static_cast<size_t>(file.gcount()));
+    } else {
+        // Size unknown, e.g. a pipe
+        out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+}
+
+#if defined(JIBBY_HAVE_MMAP)
+// A regular file of known size, read from an open descriptor. A file cut short while it is
+// read keeps what was there
+bool readAll(int fd, size_t size, string& out) {
+    out.resize(size);
+    size_t done = 0;
+    while (done < size) {
+        const ssize_t n = ::read(fd, &out[done], size - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        if (n == 0) break;
+        done += static_cast<size_t>(n);
+    }
+    out.resize(done);
+    return true;
+}
+#endif
+
+} // namespace
+
+bool JsonMappedFile::supported() {
+#if defined(JIBBY_HAVE_MMAP)
+    return true;
+#else
+    return false;
+#endif
+}
+
+JsonMappedFile::JsonMappedFile(const string& filepath, size_t minMappedSize) {
+#if defined(JIBBY_HAVE_MMAP)
+    const int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw JsonException("Failed to open file for reading: " + filepath);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        const size_t size = static_cast<size_t>(info.st_size);
+        if (size < minMappedSize) {
+            const bool complete = readAll(fd, size, contents);
+            ::close(fd);
+            if (!complete) throw JsonException("Error while reading file: " + filepath);
+            view = contents;
+            return;
+        }
+        void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            // The parser reads front to back, so let the kernel read ahead aggressively
+            ::madvise(address, size, MADV_SEQUENTIAL);
+            mapping = address;
+            mappingSize = size;
+            view = std::string_view(static_cast<const char*>(address), size);
+        }
+    }
+    ::close(fd);
+    if (mapping != nullptr) return;
+#endif
+    readWhole(filepath, contents);
+    view = contents;
+}
+
+JsonMappedFile::JsonMappedFile(JsonMappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+JsonMappedFile& JsonMappedFile::operator=(JsonMappedFile&& other) noexcept {
+    if (this == &other) return *this;
+    unmap();
+    mapping = std::exchange(other.mapping, nullptr);
+    mappingSize = std::exchange(other.mappingSize, 0);
+    contents = std::move(other.contents);
+    // A moved string may not keep its buffer, so the view is taken afresh
+    view = mapping != nullptr ? other.view : std::string_view(contents);
+    other.contents.clear();
+    other.view = std::string_view();
+    return *this;
+}
+
+JsonMappedFile::~JsonMappedFile() {
+    unmap();
+}
+
+void JsonMappedFile::unmap() {
+#if defined(JIBBY_HAVE_MMAP)
+    if (mapping != nullptr) ::munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+}
+
+}
@@ -0,0 +1,212 @@
+#include "json_number.h"
+#include <charconv>
+#include <limits>
+
+#include <cmath>
+#include <cstring>
+
+#if !defined(__cpp_lib_to_chars)
+    #include <cstdio>
+    #include <locale>
+    #include <sstream>
+    #include <string>
+#endif
+
+using namespace std;
+
+namespace jibby {
+
+namespace {
+
+// Powers of ten that are exactly representable as doubles
+constexpr double EXACT_POWERS_OF_TEN[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+constexpr uint64_t MAX_EXACT_INTEGER = uint64_t(1) << 53;
+
+int countDigits(uint64_t value) {
+    int count = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++count;
+    }
+    return count;
+}
+
+// Correctly rounded conversion of the full spelling
+bool convertText(std::string_view text, double& out) {
+#if defined(__cpp_lib_to_chars)
+    auto result = std::from_chars(text.data(), text.data() + text.size(), out);
+    return result.ec == std::errc();
+#else
+    std::istringstream in{std::string(text)};
+    in.imbue(std::locale::classic());
+    in >> out;
+    return !in.fail() && std::isfinite(out);
+#endif
+}
+
+// Shortest round-trip spelling of a finite double
+size_t shortestText(double value, char* out) {
+#if defined(__cpp_lib_to_chars)
+    auto result = std::to_chars(out, out + JsonNumber::MAX_DOUBLE_LENGTH, value);
+    return static_cast<size_t>(result.ptr - out);
+#else
+    // Try increasing precision until the text reads back exactly; 17 digits always does
+    int length = 0;
+    for (int precision = 15; precision <= 17; ++precision) {
+        length = std::snprintf(out, JsonNumber::MAX_DOUBLE_LENGTH, "%.*g", precision, value);
+        // snprintf follows the C locale, undo a decimal comma
+        for (int i = 0; i < length; ++i) {
+            if (out[i] == ',') out[i] = '.';
+        }
+        double parsed = 0.0;
+        if (convertText(std::string_view(out, static_cast<size_t>(length)), parsed) && parsed == value) break;
+    }
+    return static_cast<size_t>(length);
+#endif
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+} // namespace
+
+// The digits are accumulated into the decomposition in the same pass that validates them
+bool JsonNumber::parse(std::string_view text, JsonNumber& n, const char*& error, size_t& offset) {
+    n = JsonNumber{};
+    size_t pos = 0;
+    int significant = 0;
+    const auto peek = [&] { return pos < text.size() ? text[pos] : '\0'; };
+    const auto fail = [&](const char* message, size_t at) {
+        error = message;
+        offset = at;
+        return false;
+    };
+
+    auto addDigit = [&](char c, bool fraction) {
+        const unsigned digit = static_cast<unsigned>(c - '0');
+        if (n.digits == 0 && digit == 0) {
+            // Leading zeroes only shift the decimal point
+            if (fraction) n.exponent--;
+        } else if (significant < MAX_DIGITS) {
+            n.digits = n.digits * 10 + digit;
+            significant++;
+            if (fraction) n.exponent--;
+        } else {
+            if (digit != 0) n.truncated = true;
+            if (!fraction) n.exponent++;
+        }
+    };
+
+    if (peek() == '-') {
+        n.negative = true;
+        ++pos;
+        if (!isDigit(peek())) return fail("Invalid number", 0);
+    }
+
+    if (peek() == '0') {
+        ++pos;
+        if (isDigit(peek())) return fail("Leading zeroes are not allowed", pos);
+    } else if (isDigit(peek())) {
+        while (isDigit(peek())) addDigit(text[pos++], false);
+    } else {
+        return fail("Invalid number", 0);
+    }
+
+    if (peek() == '.') {
+        n.integer = false;
+        ++pos;
+        if (!isDigit(peek())) return fail("Invalid number", pos);
+        while (isDigit(peek())) addDigit(text[pos++], true);
+    }
+
+    if (peek() == 'e' || peek() == 'E') {
+        n.integer = false;
+        ++pos;
+        bool negativeExponent = false;
+        if (peek() == '+' || peek() == '-') negativeExponent = text[pos++] == '-';
+        if (!isDigit(peek())) return fail("Invalid exponent", pos);
+        // Saturate, anything this large is out of range for a double either way
+        int64_t exponent = 0;
+        while (isDigit(peek())) {
+            if (exponent < 100000) exponent = exponent * 10 + (text[pos] - '0');
+            ++pos;
+        }
+        n.exponent += negativeExponent ? -exponent : exponent;
+    }
+
+    if (pos < text.size()) return fail("Invalid number", pos);
+    return true;
+}
+
+size_t JsonNumber::formatDouble(double value, char* out) {
+    if (!std::isfinite(value)) {
+        std::memcpy(out, "null", 4);
+        return 4;
+    }
+
+    size_t length = shortestText(value, out);
+    if (std::memchr(out, '.', length) == nullptr && std::memchr(out, 'e', length) == nullptr) {
+        out[length++] = '.';
+        out[length++] = '0';
+    }
+    return length;
+}
+
+bool JsonNumber::toInt64(int64_t& out) const {
+    if (!integer || truncated || exponent != 0) return false;
+    const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+    if (negative) {
+        // -0 stays a double to keep its sign
+        if (digits == 0 || digits > limit + 1) return false;
+        out = static_cast<int64_t>(0 - digits);
+    } else {
+        if (digits > limit) return false;
+        out = static_cast<int64_t>(digits);
+    }
+    return true;
+}
+
+bool JsonNumber::toUInt64(std::string_view text, uint64_t& out) const {
+    if (!integer || negative) return false;
+    if (!truncated && exponent == 0) {
+        out = digits;
+        return true;
+    }
+    // Twenty digit values are the only ones past the digits kept that can still fit
+    auto result = std::from_chars(text.data(), text.data() + text.size(), out);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+bool JsonNumber::toDouble(std::string_view text, double& out) const {
+    if (!truncated) {
+        if (digits == 0) {
+            out = negative ? -0.0 : 0.0;
+            return true;
+        }
+
+        // Clinger's fast path: both operands are exact, so the single rounding step is correct
+        if (digits <= MAX_EXACT_INTEGER && exponent >= -22 && exponent <= 22) {
+            double value = static_cast<double>(digits);
+            if (exponent < 0) value /= EXACT_POWERS_OF_TEN[-exponent];
+            else value *= EXACT_POWERS_OF_TEN[exponent];
+            out = negative ? -value : value;
+            return true;
+        }
+    }
+
+    if (convertText(text, out)) return true;
+
+    // Out of range: too small rounds to zero, too large has no double
+    if (digits == 0 || exponent + countDigits(digits) <= 0) {
+        out = negative ? -0.0 : 0.0;
+        return true;
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,198 @@
+#include "json_object.h"
+#include "json.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define JIBBY_OBJECT_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace jibby {
+
+namespace {
+
+constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+// First position at or after pos whose hash equals hash, or count if none
+size_t matchHash(const uint32_t* hashes, size_t pos, size_t count, uint32_t hash) {
+#if defined(JIBBY_OBJECT_SSE2)
+    const __m128i wanted = _mm_set1_epi32(static_cast<int>(hash));
+    for (; pos + 4 <= count; pos += 4) {
+        const __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hashes + pos));
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(lanes, wanted)));
+        if (mask != 0) {
+            int lane = 0;
+            while (!(mask & (1 << lane))) ++lane;
+            return pos + static_cast<size_t>(lane);
+        }
+    }
+#endif
+    for (; pos < count; ++pos) {
+        if (hashes[pos] == hash) return pos;
+    }
+    return count;
+}
+
+} // namespace
+
+// ---- Capacity ----
+size_t JsonObject::size() const { return members.size(); }
+bool JsonObject::empty() const { return members.empty(); }
+
+// Room for the index as well, once count members need one, so filling up to count never
+// reallocates either vector
+void JsonObject::reserve(size_t count) {
+    members.reserve(count);
+    size_t slots = slotCount();
+    if (count > INDEX_THRESHOLD && slots == 0) slots = INDEX_THRESHOLD * 4;
+    while (slots != 0 && count * 2 > slots) slots *= 2;
+    lookup.reserve(slots + count);
+}
+
+void JsonObject::clear() {
+    members.clear();
+    lookup.clear();
+}
+
+// ---- Iteration ----
+JsonObject::iterator JsonObject::at(size_t pos) { return iterator(members.data() + pos); }
+JsonObject::const_iterator JsonObject::at(size_t pos) const { return const_iterator(members.data() + pos); }
+
+JsonObject::iterator JsonObject::begin() { return at(0); }
+JsonObject::iterator JsonObject::end() { return at(members.size()); }
+JsonObject::const_iterator JsonObject::begin() const { return at(0); }
+JsonObject::const_iterator JsonObject::end() const { return at(members.size()); }
+
+// ---- Lookup ----
+size_t JsonObject::slotCount() const {
+    return lookup.size() - members.size();
+}
+
+size_t JsonObject::position(std::string_view key, uint32_t hash) const {
+    const size_t slots = slotCount();
+    const size_t count = members.size();
+    const uint32_t* hashes = lookup.data() + slots;
+
+    if (slots == 0) {
+        for (size_t pos = matchHash(hashes, 0, count, hash); pos < count; pos = matchHash(hashes, pos + 1, count, hash)) {
+            if (members[pos].first == key) return pos;
+        }
+        return NOT_FOUND;
+    }
+
+    const size_t mask = slots - 1;
+    for (size_t slot = hash & mask; lookup[slot] != 0; slot = (slot + 1) & mask) {
+        const size_t pos = lookup[slot] - 1;
+        if (hashes[pos] == hash && members[pos].first == key) return pos;
+    }
+    return NOT_FOUND;
+}
+
+JsonObject::iterator JsonObject::find(std::string_view key) {
+    const size_t pos = position(key, JsonKey::hashText(key));
+    return at(pos == NOT_FOUND ? members.size() : pos);
+}
+
+JsonObject::const_iterator JsonObject::find(std::string_view key) const {
+    const size_t pos = position(key, JsonKey::hashText(key));
+    return at(pos == NOT_FOUND ? members.size() : pos);
+}
+
+JsonObject::iterator JsonObject::find(const JsonKey& key) {
+    const size_t pos = position(key, key.hash());
+    return at(pos == NOT_FOUND ? members.size() : pos);
+}
+
+JsonObject::const_iterator JsonObject::find(const JsonKey& key) const {
+    const size_t pos = position(key, key.hash());
+    return at(pos == NOT_FOUND ? members.size() : pos);
+}
+
+size_t JsonObject::count(std::string_view key) const {
+    return position(key, JsonKey::hashText(key)) == NOT_FOUND ? 0 : 1;
+}
+
+// ---- Modifiers ----
+JsonObject::Member& JsonObject::append(JsonKey&& key, Json&& value) {
+    const uint32_t hash = key.hash();
+    members.emplace_back(std::move(key), std::move(value));
+    lookup.push_back(hash);
+
+    const size_t count = members.size();
+    const size_t slots = slotCount();
+    if (slots == 0) {
+        if (count > INDEX_THRESHOLD) reindex(INDEX_THRESHOLD * 4);
+    } else if (count * 2 > slots) {
+        reindex(slots * 2);
+    } else {
+        const size_t mask = slots - 1;
+        size_t slot = hash & mask;
+        while (lookup[slot] != 0) slot = (slot + 1) & mask;
+        lookup[slot] = static_cast<uint32_t>(count);
+    }
+    return members.back();
+}
+
+// Resize the index to slots entries (a power of two, or 0 to drop it) and refill it
+void JsonObject::reindex(size_t slots) {
+    const size_t current = slotCount();
+    if (slots > current) lookup.insert(lookup.begin(), slots - current, 0);
+    else lookup.erase(lookup.begin(), lookup.begin() + static_cast<ptrdiff_t>(current - slots));
+    if (slots == 0) return;
+
+    std::fill(lookup.begin(), lookup.begin() + static_cast<ptrdiff_t>(slots), 0);
+    const size_t mask = slots - 1;
+    for (size_t pos = 0; pos < members.size(); ++pos) {
+        size_t slot = lookup[slots + pos] & mask;
+        while (lookup[slot] != 0) slot = (slot + 1) & mask;
+        lookup[slot] = static_cast<uint32_t>(pos + 1);
+    }
+}
+
+Json& JsonObject::operator[](std::string_view key) {
+    const size_t pos = position(key, JsonKey::hashText(key));
+    if (pos != NOT_FOUND) return members[pos].second;
+    return append(JsonKey(key, resource()), Json()).second;
+}
+
+std::pair<JsonObject::iterator, bool> JsonObject::insert_or_assign(std::string_view key, Json value) {
+    const size_t pos = position(key, JsonKey::hashText(key));
+    if (pos != NOT_FOUND) {
+        members[pos].second = std::move(value);
+        return {at(pos), false};
+    }
+    append(JsonKey(key, resource()), std::move(value));
+    return {at(members.size() - 1), true};
+}
+
+std::pair<JsonObject::iterator, bool> JsonObject::insert_or_assign(JsonKey key, Json value) {
+    const size_t pos = position(key, key.hash());
+    if (pos != NOT_FOUND) {
+        members[pos].second = std::move(value);
+        return {at(pos), false};
+    }
+    append(std::move(key), std::move(value));
+    return {at(members.size() - 1), true};
+}
+
+size_t JsonObject::erase(std::string_view key) {
+    const size_t pos = position(key, JsonKey::hashText(key));
+    if (pos == NOT_FOUND) return 0;
+    erase(at(pos));
+    return 1;
+}
+
+JsonObject::iterator JsonObject::erase(const_iterator it) {
+    const ptrdiff_t pos = it - begin();
+    const size_t slots = slotCount();
+    members.erase(members.begin() + pos);
+    lookup.erase(lookup.begin() + static_cast<ptrdiff_t>(slots) + pos);
+
+    // Positions after the removed member shifted, so the index is rebuilt
+    if (slots != 0) reindex(members.size() > INDEX_THRESHOLD ? slots : 0);
+    return at(static_cast<size_t>(pos));
+}
+
+}
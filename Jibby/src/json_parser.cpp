@@ -1,15 +1,119 @@
 #include "json_parser.h"
+#include "json_dom_builder.h"
+#include "json_lines_reader.h"
+#include "json_projection.h"
+#include <algorithm>
+#include <chrono>
 
 using namespace std; // Safe in implementation file only
 
 namespace jibby {
 
-JsonParser::JsonParser(const string& jsonText)
+// Counts one parse call into the parser's stats, if any: its time, the input it read and what
+// it allocated, whether it returns or throws
+class JsonParser::StatsScope {
+    public:
+#if defined(JIBBY_STATS)
+        explicit StatsScope(JsonParser& parser) : parser(parser) {
+            if (!parser.stats) return;
+            parser.depth = 0;
+            counting = dynamic_cast<JsonCountingResource*>(parser.resource);
+            if (counting) {
+                allocations = counting->allocations();
+                allocatedBytes = counting->allocatedBytes();
+            }
+            start = chrono::steady_clock::now();
+        }
+
+        ~StatsScope() {
+            JsonParseStats* stats = parser.stats;
+            if (!stats) return;
+            stats->seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            ++stats->parses;
+            stats->bytes += parser.tokenizer.consumed();
+            if (counting) {
+                stats->allocations += counting->allocations() - allocations;
+                stats->allocatedBytes += counting->allocatedBytes() - allocatedBytes;
+            }
+        }
+
+    private:
+        JsonParser& parser;
+        JsonCountingResource* counting = nullptr;
+        size_t allocations = 0;
+        size_t allocatedBytes = 0;
+        chrono::steady_clock::time_point start;
+#else
+        explicit StatsScope(JsonParser&) {}
+#endif
+};
+
+JsonParser::JsonParser(std::string_view jsonText)
     : tokenizer(jsonText) {
     advance();
 }
 
+JsonParser::JsonParser(const char* jsonText)
+    : JsonParser(std::string_view(jsonText)) {}
+
+JsonParser::JsonParser(const char* data, size_t length)
+    : JsonParser(std::string_view(data, length)) {}
+
+JsonParser::JsonParser(string&& jsonText)
+    : owned(std::move(jsonText)), tokenizer(owned) {
+    advance();
+}
+
+JsonParser::JsonParser(std::string_view jsonText, std::pmr::memory_resource* resource)
+    : tokenizer(jsonText), resource(resource) {
+    advance();
+}
+
+JsonParser::JsonParser(std::istream& in, size_t chunkSize)
+    : JsonParser(JsonSource([&in](char* buffer, size_t capacity) -> size_t {
+          in.read(buffer, static_cast<std::streamsize>(capacity));
+          if (in.bad()) throw JsonException("Error while reading input stream");
+          return static_cast<size_t>(in.gcount());
+      }), chunkSize) {}
+
+JsonParser::JsonParser(JsonSource source, size_t chunkSize)
+    : tokenizer(std::move(source), chunkSize) {
+    advance();
+}
+
+JsonParser::JsonParser(std::string_view document, size_t begin, size_t end)
+    : tokenizer(document, begin, end) {
+    advance();
+}
+
+JsonParser::JsonParser(std::string_view jsonText, JsonKeyPool& keys)
+    : tokenizer(jsonText), keys(&keys) {
+    advance();
+}
+
+JsonParser::JsonParser(std::string_view jsonText, std::pmr::memory_resource* resource, JsonKeyPool& keys)
+    : tokenizer(jsonText), resource(resource), keys(&keys) {
+    advance();
+}
+
+void JsonParser::collect(JsonParseStats& target) {
+#if defined(JIBBY_STATS)
+    stats = &target;
+    tokenizer.collect(&target, current);
+#else
+    (void)target;
+#endif
+}
+
 void JsonParser::advance() {
+#if defined(JIBBY_STATS)
+    if (stats && stats->timeTokenizer) {
+        const auto start = chrono::steady_clock::now();
+        current = tokenizer.getNextToken();
+        stats->tokenizeSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return;
+    }
+#endif
     current = tokenizer.getNextToken();
 }
 
@@ -21,101 +125,248 @@ bool JsonParser::match(TokenType expected) {
     return false;
 }
 
-void JsonParser::expect(TokenType expected, const string& errorMsg) {
+void JsonParser::expect(TokenType expected, const char* errorMsg) {
     if (!match(expected)) {
-        throw JsonParseException(errorMsg, current.line, current.column);
+        throw tokenizer.error(errorMsg, current.offset);
     }
 }
 
 Json JsonParser::parse() {
-    Json value = parseValue();
+    StatsScope scope(*this);
+    JsonDomBuilder builder(resource, keys);
+    parseDocument(builder);
+    return builder.result();
+}
+
+Json JsonParser::parseParallel(JsonWorkerPool* pool) {
+    const std::string_view text = tokenizer.document();
+    if (current.type != TokenType::LEFT_BRACKET || text.size() < PARALLEL_THRESHOLD
+        || resource != std::pmr::get_default_resource() || keys != nullptr) {
+        return parse();
+    }
+
+    StatsScope scope(*this);
+    // Elements come back in order; an error in any of them, or in the array around them, is
+    // thrown with its place in the whole text
+    Array elements;
+    JsonLinesReader(text, JsonLinesReader::Format::Elements, pool).forEach([&](size_t, Json& element) {
+        elements.push_back(std::move(element));
+        return true;
+    });
+    // The elements were read by parsers of their own
+    JIBBY_STAT(stats, stats->bytes += text.size() - tokenizer.consumed());
+    return Json(std::move(elements));
+}
+
+bool JsonParser::parse(JsonHandler& handler) {
+    StatsScope scope(*this);
+    return parseDocument(handler);
+}
+
+Json JsonParser::parse(const JsonProjection& projection) {
+    StatsScope scope(*this);
+    JsonDomBuilder builder(resource, keys);
+    JsonProjectingHandler filter(projection, builder);
+    parseDocument(filter);
+    return builder.result();
+}
+
+template <typename Handler>
+bool JsonParser::parseDocument(Handler& handler) {
+    if (!parseValue(handler)) return false;
     if (current.type != TokenType::END_OF_FILE) {
-        throw JsonParseException("Unexpected trailing content", current.line, current.column);
+        throw tokenizer.error("Unexpected trailing content", current.offset);
     }
-    return value;
+    return true;
 }
 
-Json JsonParser::parseValue() {
+template <typename Handler>
+bool JsonParser::parseValue(Handler& handler) {
     switch (current.type) {
-        case TokenType::LEFT_BRACE:   return parseObject();
-        case TokenType::LEFT_BRACKET: return parseArray();
-        case TokenType::STRING:       return parseString();
-        case TokenType::NUMBER:       return parseNumber();
+        case TokenType::LEFT_BRACE:   return parseObject(handler);
+        case TokenType::LEFT_BRACKET: return parseArray(handler);
+        case TokenType::STRING: {
+            const JsonHandler::Action action = handler.string(tokenizer.text(current));
+            advance();
+            return action != JsonHandler::Action::Stop;
+        }
+        case TokenType::NUMBER:       return parseNumber(handler);
         case TokenType::TRUE:         
         case TokenType::FALSE:        
-        case TokenType::NUL:          return parseLiteral();
+        case TokenType::NUL:          return parseLiteral(handler);
         default:
-            throw JsonParseException("Unexpected token", current.line, current.column);
+            throw tokenizer.error("Unexpected token", current.offset);
     }
 }
 
-Json JsonParser::parseObject() {
-    Json obj = Json::object();
+template <typename Handler>
+bool JsonParser::parseObject(Handler& handler) {
+    const JsonHandler::Action start = handler.startObject();
+    if (start == JsonHandler::Action::Stop) return false;
+    if (start == JsonHandler::Action::Skip || start == JsonHandler::Action::SkipUnchecked) {
+        skip(start);
+        return true;
+    }
     advance(); // consume '{'
+    JIBBY_STAT(stats, {
+        ++stats->objects;
+        stats->maxDepth = std::max(stats->maxDepth, ++depth);
+    });
 
-    if (match(TokenType::RIGHT_BRACE)) return obj;
-
-    do {
-        if (current.type != TokenType::STRING)
-            throw JsonParseException("Expected string key in object", current.line, current.column);
+    if (!match(TokenType::RIGHT_BRACE)) {
+        do {
+            if (current.type != TokenType::STRING)
+                throw tokenizer.error("Expected string key in object", current.offset);
 
-        std::string key = current.value;
-        advance(); // consume key token
+            JIBBY_STAT(stats, ++stats->members);
+            const JsonHandler::Action action = handler.key(tokenizer.text(current));
+            if (action == JsonHandler::Action::Stop) return false;
+            advance(); // consume key token
 
-        expect(TokenType::COLON, "Expected ':' after key");
+            expect(TokenType::COLON, "Expected ':' after key");
 
-        obj.asObject()[key] = parseValue();
-    } while (match(TokenType::COMMA));
+            if (action == JsonHandler::Action::Skip || action == JsonHandler::Action::SkipUnchecked) skip(action);
+            else if (!parseValue(handler)) return false;
+        } while (match(TokenType::COMMA));
 
-    expect(TokenType::RIGHT_BRACE, "Expected '}' at end of object");
-    return obj;
+        expect(TokenType::RIGHT_BRACE, "Expected '}' at end of object");
+    }
+    JIBBY_STAT(stats, --depth);
+    return handler.endObject() != JsonHandler::Action::Stop;
 }
 
-Json JsonParser::parseArray() {
-    Json arr = Json::array();
+template <typename Handler>
+bool JsonParser::parseArray(Handler& handler) {
+    const JsonHandler::Action start = handler.startArray();
+    if (start == JsonHandler::Action::Stop) return false;
+    if (start == JsonHandler::Action::Skip || start == JsonHandler::Action::SkipUnchecked) {
+        skip(start);
+        return true;
+    }
     advance(); // consume '['
+    JIBBY_STAT(stats, {
+        ++stats->arrays;
+        stats->maxDepth = std::max(stats->maxDepth, ++depth);
+    });
 
-    if (match(TokenType::RIGHT_BRACKET)) return arr;
-
-    do {
-        arr.asArray().push_back(parseValue());
-    } while (match(TokenType::COMMA));
-
-    expect(TokenType::RIGHT_BRACKET, "Expected ']' at end of array");
-    return arr;
-}
+    if (!match(TokenType::RIGHT_BRACKET)) {
+        do {
+            const JsonHandler::Action action = handler.element();
+            if (action == JsonHandler::Action::Stop) return false;
+            if (action == JsonHandler::Action::Skip || action == JsonHandler::Action::SkipUnchecked) skip(action);
+            else if (!parseValue(handler)) return false;
+        } while (match(TokenType::COMMA));
 
-Json JsonParser::parseString() {
-    string val = current.value;
-    advance();
-    return Json(val);
+        expect(TokenType::RIGHT_BRACKET, "Expected ']' at end of array");
+    }
+    JIBBY_STAT(stats, --depth);
+    return handler.endArray() != JsonHandler::Action::Stop;
 }
 
-Json JsonParser::parseNumber() {
+template <typename Handler>
+bool JsonParser::parseNumber(Handler& handler) {
+    // Integers are kept exact as int64, or uint64 past the int64 range. Everything else is a double
+    const JsonNumber& number = tokenizer.numberValue();
+    JsonHandler::Action action;
+    int64_t signedValue = 0;
+    uint64_t unsignedValue = 0;
     double num = 0.0;
-    try {
-        num = stod(current.value);
-    } catch (const std::exception&) {
-        throw JsonParseException("Invalid number", current.line, current.column);
+    if (number.toInt64(signedValue)) {
+        action = handler.int64(signedValue);
+    } else if (number.toUInt64(tokenizer.text(current), unsignedValue)) {
+        action = handler.uint64(unsignedValue);
+    } else if (number.toDouble(tokenizer.text(current), num)) {
+        action = handler.number(num);
+    } else {
+        throw tokenizer.error("Invalid number", current.offset);
     }
     advance();
-    return Json(num);
+    return action != JsonHandler::Action::Stop;
 }
 
-Json JsonParser::parseLiteral() {
+template <typename Handler>
+bool JsonParser::parseLiteral(Handler& handler) {
+    JsonHandler::Action action;
     if (current.type == TokenType::TRUE) {
-        advance();
-        return Json(true);
+        action = handler.boolean(true);
+    } else if (current.type == TokenType::FALSE) {
+        action = handler.boolean(false);
+    } else if (current.type == TokenType::NUL) {
+        action = handler.null();
+    } else {
+        throw tokenizer.error("Unexpected literal", current.offset);
     }
-    if (current.type == TokenType::FALSE) {
-        advance();
-        return Json(false);
+    advance();
+    return action != JsonHandler::Action::Stop;
+}
+
+// Same grammar as parseValue(), with no events and no number conversion
+void JsonParser::validate(vector<std::pair<size_t, size_t>>* containers) {
+    StatsScope scope(*this);
+    spans = containers;
+    skipValue();
+    spans = nullptr;
+    if (current.type != TokenType::END_OF_FILE) {
+        throw tokenizer.error("Unexpected trailing content", current.offset);
+    }
+}
+
+void JsonParser::skip(JsonHandler::Action action) {
+    if (action == JsonHandler::Action::SkipUnchecked) skipUnchecked();
+    else skipValue();
+}
+
+// Containers are stepped over in the structural index, which already knows which brackets are
+// inside strings. Streamed input has no index, so it is skipped token by token instead
+void JsonParser::skipUnchecked() {
+    const bool container = current.type == TokenType::LEFT_BRACE || current.type == TokenType::LEFT_BRACKET;
+    if (!container || !tokenizer.skipContainer(current.type == TokenType::LEFT_BRACE ? '{' : '[')) {
+        skipValue();
+        return;
     }
-    if (current.type == TokenType::NUL) {
-        advance();    
-        return Json(nullptr);
+    advance();
+}
+
+void JsonParser::skipValue() {
+    // Slot of this container in spans, filled in with its closing offset once that is reached
+    const size_t span = spans != nullptr ? spans->size() : 0;
+    switch (current.type) {
+        case TokenType::LEFT_BRACE:
+            if (spans != nullptr) spans->emplace_back(current.offset, current.offset);
+            advance();
+            if (current.type != TokenType::RIGHT_BRACE) {
+                do {
+                    if (current.type != TokenType::STRING)
+                        throw tokenizer.error("Expected string key in object", current.offset);
+                    advance();
+                    expect(TokenType::COLON, "Expected ':' after key");
+                    skipValue();
+                } while (match(TokenType::COMMA));
+            }
+            if (spans != nullptr) (*spans)[span].second = current.offset;
+            expect(TokenType::RIGHT_BRACE, "Expected '}' at end of object");
+            return;
+        case TokenType::LEFT_BRACKET:
+            if (spans != nullptr) spans->emplace_back(current.offset, current.offset);
+            advance();
+            if (current.type != TokenType::RIGHT_BRACKET) {
+                do {
+                    skipValue();
+                } while (match(TokenType::COMMA));
+            }
+            if (spans != nullptr) (*spans)[span].second = current.offset;
+            expect(TokenType::RIGHT_BRACKET, "Expected ']' at end of array");
+            return;
+        case TokenType::STRING:
+        case TokenType::NUMBER:
+        case TokenType::TRUE:
+        case TokenType::FALSE:
+        case TokenType::NUL:
+            advance();
+            return;
+        default:
+            throw tokenizer.error("Unexpected token", current.offset);
     }
-    throw JsonParseException("Unexpected literal", current.line, current.column);
 }
 
 } // namespace jibby
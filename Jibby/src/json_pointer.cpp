@@ -0,0 +1,83 @@
+#include "json_pointer.h"
+#include "json_exception.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace jibby {
+
+namespace {
+
+// Array index spelled by a segment: digits without a leading zero. "-", the element after the
+// last, never refers to an existing value
+size_t segmentIndex(std::string_view segment) {
+    if (segment.empty() || segment.size() > 18 || (segment.size() > 1 && segment[0] == '0')) {
+        return JsonPointer::NOT_INDEX;
+    }
+    size_t index = 0;
+    for (char c : segment) {
+        if (c < '0' || c > '9') return JsonPointer::NOT_INDEX;
+        index = index * 10 + static_cast<size_t>(c - '0');
+    }
+    return index;
+}
+
+} // namespace
+
+JsonPointer::JsonPointer(std::string_view pointer) : text(pointer) {
+    if (!pointer.empty() && pointer[0] != '/') {
+        throw JsonException("JSON Pointer must be empty or start with '/': " + text);
+    }
+
+    size_t pos = 0;
+    while (pos < pointer.size()) {
+        const size_t end = std::min(pointer.find('/', pos + 1), pointer.size());
+        string key;
+        for (size_t i = pos + 1; i < end; ++i) {
+            if (pointer[i] != '~') {
+                key.push_back(pointer[i]);
+            } else if (i + 1 < end && (pointer[i + 1] == '0' || pointer[i + 1] == '1')) {
+                key.push_back(pointer[++i] == '0' ? '~' : '/');
+            } else {
+                throw JsonException("Invalid escape in JSON Pointer: " + text);
+            }
+        }
+        segments.push_back(Segment{JsonKey(key), segmentIndex(key)});
+        pos = end;
+    }
+}
+
+size_t JsonPointer::resolve(const Json& root, const Json*& found) const {
+    found = &root;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const Json* next = found->isArray() ? found->find(segments[i].index) : found->find(segments[i].key);
+        if (next == nullptr) return i;
+        found = next;
+    }
+    return segments.size();
+}
+
+const Json* JsonPointer::find(const Json& root) const {
+    const Json* found = nullptr;
+    return resolve(root, found) == segments.size() ? found : nullptr;
+}
+
+Json* JsonPointer::find(Json& root) const {
+    return const_cast<Json*>(find(static_cast<const Json&>(root)));
+}
+
+const Json& JsonPointer::at(const Json& root) const {
+    const Json* found = nullptr;
+    const size_t resolved = resolve(root, found);
+    if (resolved < segments.size()) {
+        throw JsonException("JSON Pointer " + text + " has no value at segment " + to_string(resolved)
+                            + ": " + string(std::string_view(segments[resolved].key)));
+    }
+    return *found;
+}
+
+Json& JsonPointer::at(Json& root) const {
+    return const_cast<Json&>(at(static_cast<const Json&>(root)));
+}
+
+}
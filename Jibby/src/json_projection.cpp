@@ -0,0 +1,144 @@
+#include "json_projection.h"
+#include "json_pointer.h"
+
+using namespace std;
+
+namespace jibby {
+
+// ---- JsonProjection ----
+
+JsonProjection::JsonProjection(std::initializer_list<std::string_view> paths) {
+    for (std::string_view path : paths) add(path);
+}
+
+JsonProjection::JsonProjection(const vector<string>& paths) {
+    for (const string& path : paths) add(path);
+}
+
+void JsonProjection::add(std::string_view path) {
+    const JsonPointer pointer(path);
+    size_t node = 0;
+    for (size_t i = 0; i < pointer.size(); ++i) {
+        const std::string_view key = pointer.segment(i);
+        size_t next = NONE;
+        if (key == "*") {
+            if (nodes[node].wildcard == NONE) {
+                nodes[node].wildcard = nodes.size();
+                nodes.emplace_back();
+            }
+            next = nodes[node].wildcard;
+        } else {
+            for (const Segment& segment : nodes[node].children) {
+                if (segment.key == key) next = segment.node;
+            }
+            if (next == NONE) {
+                next = nodes.size();
+                const size_t index = pointer.index(i) == JsonPointer::NOT_INDEX ? NONE : pointer.index(i);
+                nodes[node].children.push_back(Segment{string(key), index, next});
+                nodes.emplace_back();
+            }
+        }
+        node = next;
+    }
+    nodes[node].whole = true;
+}
+
+size_t JsonProjection::root() const {
+    return matched(0);
+}
+
+size_t JsonProjection::child(size_t node, std::string_view key) const {
+    if (node == ALL) return ALL;
+    for (const Segment& segment : nodes[node].children) {
+        if (segment.key == key) return matched(segment.node);
+    }
+    return nodes[node].wildcard == NONE ? NONE : matched(nodes[node].wildcard);
+}
+
+size_t JsonProjection::child(size_t node, size_t index) const {
+    if (node == ALL) return ALL;
+    for (const Segment& segment : nodes[node].children) {
+        if (segment.index == index) return matched(segment.node);
+    }
+    return nodes[node].wildcard == NONE ? NONE : matched(nodes[node].wildcard);
+}
+
+// ---- JsonProjectingHandler ----
+
+JsonProjectingHandler::JsonProjectingHandler(const JsonProjection& projection, JsonHandler& target)
+    : projection(projection), target(target), pending(projection.root()) {}
+
+// Values that are not kept are skipped from key() and element(), so every value event is for
+// a kept value, at path node pending
+JsonHandler::Action JsonProjectingHandler::open(bool array) {
+    const Action action = array ? target.startArray() : target.startObject();
+    if (action == Action::Continue) frames.push_back(Frame{pending, array, 0, 0});
+    return action;
+}
+
+JsonHandler::Action JsonProjectingHandler::startObject() {
+    return open(false);
+}
+
+JsonHandler::Action JsonProjectingHandler::key(std::string_view name) {
+    pending = projection.child(frames.back().node, name);
+    if (pending == JsonProjection::NONE) return Action::SkipUnchecked;
+    return target.key(name);
+}
+
+JsonHandler::Action JsonProjectingHandler::endObject() {
+    frames.pop_back();
+    return target.endObject();
+}
+
+JsonHandler::Action JsonProjectingHandler::startArray() {
+    return open(true);
+}
+
+// Array elements are matched by position. Those skipped before a kept one are only passed on
+// then, as nulls, so none is passed on for skipped elements at the end of the array
+JsonHandler::Action JsonProjectingHandler::element() {
+    Frame& frame = frames.back();
+    pending = projection.child(frame.node, frame.index++);
+    if (pending == JsonProjection::NONE) {
+        ++frame.skipped;
+        return Action::SkipUnchecked;
+    }
+    for (; frame.skipped > 0; --frame.skipped) {
+        const Action action = target.element();
+        if (action == Action::Stop) return action;
+        if (action == Action::Continue && target.null() == Action::Stop) return Action::Stop;
+    }
+    return target.element();
+}
+
+JsonHandler::Action JsonProjectingHandler::endArray() {
+    frames.pop_back();
+    return target.endArray();
+}
+
+JsonHandler::Action JsonProjectingHandler::string(std::string_view value) {
+    return target.string(value);
+}
+
+JsonHandler::Action JsonProjectingHandler::boolean(bool value) {
+    return target.boolean(value);
+}
+
+JsonHandler::Action JsonProjectingHandler::null() {
+    return target.null();
+}
+
+JsonHandler::Action JsonProjectingHandler::number(double value) {
+    return target.number(value);
+}
+
+JsonHandler::Action JsonProjectingHandler::int64(int64_t value) {
+    return target.int64(value);
+}
+
+JsonHandler::Action JsonProjectingHandler::uint64(uint64_t value) {
+    return target.uint64(value);
+}
+
+}
@@ -0,0 +1,418 @@
+#include "json_push_parser.h"
+#include "json_number.h"
+#include "json_scanner.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace jibby {
+
+namespace {
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool isAlpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+bool isNumberChar(char c) {
+    return isDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return 10 + (c - 'a');
+    if (c >= 'A' && c <= 'F') return 10 + (c - 'A');
+    return -1;
+}
+
+// Same encoding as JsonTokenizer's, so both parsers decode \u escapes alike
+void appendUtf8(string& out, unsigned codePoint) {
+    if (codePoint <= 0x7F) {
+        out.push_back(static_cast<char>(codePoint));
+    } else if (codePoint <= 0x7FF) {
+        out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+bool skips(JsonHandler::Action action) {
+    return action == JsonHandler::Action::Skip || action == JsonHandler::Action::SkipUnchecked;
+}
+
+} // namespace
+
+JsonPushParser::JsonPushParser(std::pmr::memory_resource* resource, JsonKeyPool* keys)
+    : builder(resource, keys), handler(&builder), building(true) {}
+
+JsonPushParser::JsonPushParser(JsonHandler& handler)
+    : handler(&handler), building(false) {}
+
+// ---- Input ----
+bool JsonPushParser::feed(const char* data, size_t length) {
+    if (finished) throw JsonException("Cannot feed a JsonPushParser after finish()");
+    if (stopped) return false;
+
+    piece = std::string_view(data, length);
+    size_t pos = 0;
+    switch (lexeme) {
+        case Lexeme::String:  pos = resumeString(0); break;
+        case Lexeme::Number:  pos = lexNumber(0); break;
+        case Lexeme::Literal: pos = lexLiteral(0); break;
+        case Lexeme::None:    break;
+    }
+    while (!stopped && pos < piece.size()) pos = step(pos);
+
+    // Carry the line count past this piece, for locating later errors
+    const size_t newline = piece.rfind('\n');
+    if (newline != std::string_view::npos) {
+        lines += static_cast<size_t>(std::count(piece.begin(), piece.end(), '\n'));
+        lineStart = base + newline + 1;
+    }
+    base += length;
+    piece = std::string_view();
+    return !stopped;
+}
+
+bool JsonPushParser::finish() {
+    if (finished) return !stopped;
+    finished = true;
+    if (stopped) return false;
+
+    switch (lexeme) {
+        case Lexeme::String:
+            if (escape == Escape::Backslash) throw error("Unterminated string escape sequence", base);
+            if (escape == Escape::Unicode) throw error("Unterminated unicode escape", base);
+            throw error("Unterminated string literal", lexemeStart);
+        case Lexeme::Number:
+            lexeme = Lexeme::None;
+            completeNumber(pending, lexemeStart, std::string_view::npos);
+            break;
+        case Lexeme::Literal:
+            lexeme = Lexeme::None;
+            completeLiteral(pending, lexemeStart, std::string_view::npos);
+            break;
+        case Lexeme::None:
+            break;
+    }
+    if (!stopped && expect != Expect::Done) unexpected(base);
+    return !stopped;
+}
+
+Json JsonPushParser::result() {
+    if (!building) throw JsonException("JsonPushParser reports to a handler and builds no result");
+    if (!finished) throw JsonException("JsonPushParser::result() called before finish()");
+    return builder.result();
+}
+
+// ---- Tokens ----
+// One token starting at or after pos. Returns the position after it, or the end of the piece
+// if it continues in the next one
+size_t JsonPushParser::step(size_t pos) {
+    pos = JsonScanner::skipWhitespace(piece, pos);
+    if (pos == piece.size()) return pos;
+
+    const char c = piece[pos];
+    if (c != '}' && c != ']' && c != ':' && c != ',') {
+        startValue();
+        if (stopped) return pos;
+    }
+    switch (c) {
+        case '{':
+        case '[':
+            startContainer(c, base + pos);
+            return pos + 1;
+        case '}':
+        case ']':
+            endContainer(c, base + pos);
+            return pos + 1;
+        case ':':
+            if (expect != Expect::Colon) unexpected(base + pos);
+            expect = Expect::Value;
+            return pos + 1;
+        case ',':
+            if (expect != Expect::CommaOrEnd) unexpected(base + pos);
+            expect = open.back() == '{' ? Expect::Key : Expect::Value;
+            return pos + 1;
+        case '"':
+            return lexString(pos);
+    }
+
+    if (isDigit(c) || c == '-') return lexNumber(pos);
+    if (isAlpha(c)) return lexLiteral(pos);
+    throw error("Unexpected character: " + string(1, c), base + pos);
+}
+
+// A string closed within the piece and free of escapes is passed on as a view of it; anything
+// else is decoded into pending. Like JsonTokenizer's, string tokens start after the quote
+size_t JsonPushParser::lexString(size_t pos) {
+    const size_t begin = pos + 1;
+    const size_t special = JsonScanner::findStringSpecial(piece, begin);
+    if (special < piece.size() && piece[special] == '"') {
+        completeString(piece.substr(begin, special - begin), base + begin);
+        return special + 1;
+    }
+
+    lexeme = Lexeme::String;
+    lexemeStart = base + begin;
+    escape = Escape::None;
+    pending.assign(piece.data() + begin, special - begin);
+    return resumeString(special);
+}
+
+size_t JsonPushParser::resumeString(size_t pos) {
+    while (pos < piece.size()) {
+        if (escape == Escape::None) {
+            const size_t special = JsonScanner::findStringSpecial(piece, pos);
+            pending.append(piece.data() + pos, special - pos);
+            pos = special;
+            if (pos == piece.size()) break;
+
+            const char c = piece[pos++];
+            if (c == '"') {
+                lexeme = Lexeme::None;
+                completeString(pending, lexemeStart);
+                return pos;
+            }
+            if (c != '\\') throw error("Unescaped control character in string", base + pos - 1);
+            escape = Escape::Backslash;
+        } else if (escape == Escape::Backslash) {
+            const char esc = piece[pos++];
+            escape = Escape::None;
+            switch (esc) {
+                case '"':  pending.push_back('"');  break;
+                case '\\': pending.push_back('\\'); break;
+                case '/':  pending.push_back('/');  break;
+                case 'b':  pending.push_back('\b'); break;
+                case 'f':  pending.push_back('\f'); break;
+                case 'n':  pending.push_back('\n'); break;
+                case 'r':  pending.push_back('\r'); break;
+                case 't':  pending.push_back('\t'); break;
+                case 'u':
+                    escape = Escape::Unicode;
+                    hexDigits = 0;
+                    codePoint = 0;
+                    break;
+                default:
+                    throw error("Invalid escape character: " + string(1, esc), base + pos - 1);
+            }
+        } else {
+            const int value = hexValue(piece[pos++]);
+            if (value < 0) throw error("Invalid unicode escape", base + pos - 1);
+            codePoint = (codePoint << 4) | static_cast<unsigned>(value);
+            if (++hexDigits == 4) {
+                appendUtf8(pending, codePoint);
+                escape = Escape::None;
+            }
+        }
+    }
+    return pos;
+}
+
+// Numbers and literals only end at the character after them, which may be in a later piece
+size_t JsonPushParser::lexNumber(size_t pos) {
+    const size_t start = pos;
+    while (pos < piece.size() && isNumberChar(piece[pos])) ++pos;
+    const std::string_view text = piece.substr(start, pos - start);
+
+    if (pos == piece.size()) {
+        if (lexeme == Lexeme::None) {
+            lexeme = Lexeme::Number;
+            lexemeStart = base + start;
+            pending.assign(text.data(), text.size());
+        } else {
+            pending.append(text.data(), text.size());
+        }
+        return pos;
+    }
+
+    if (lexeme == Lexeme::None) {
+        completeNumber(text, base + start, pos);
+    } else {
+        lexeme = Lexeme::None;
+        pending.append(text.data(), text.size());
+        completeNumber(pending, lexemeStart, pos);
+    }
+    return pos;
+}
+
+size_t JsonPushParser::lexLiteral(size_t pos) {
+    const size_t start = pos;
+    while (pos < piece.size() && isAlpha(piece[pos])) ++pos;
+    const std::string_view text = piece.substr(start, pos - start);
+
+    if (pos == piece.size()) {
+        if (lexeme == Lexeme::None) {
+            lexeme = Lexeme::Literal;
+            lexemeStart = base + start;
+            pending.assign(text.data(), text.size());
+        } else {
+            pending.append(text.data(), text.size());
+        }
+        return pos;
+    }
+
+    if (lexeme == Lexeme::None) {
+        completeLiteral(text, base + start, pos);
+    } else {
+        lexeme = Lexeme::None;
+        pending.append(text.data(), text.size());
+        completeLiteral(pending, lexemeStart, pos);
+    }
+    return pos;
+}
+
+// A number or literal must be followed by whitespace or structure. end is the position of the
+// next character in the piece, npos at the end of the input
+void JsonPushParser::checkScalarEnd(size_t end) {
+    if (end == std::string_view::npos) return;
+    const char c = piece[end];
+    if (isAlpha(c)) throw error("Invalid number", base + end);
+    if (!JsonScanner::isWhitespace(c) && !JsonScanner::isStructural(c)) {
+        throw error("Unexpected character: " + string(1, c), base + end);
+    }
+}
+
+// ---- Values ----
+void JsonPushParser::completeString(std::string_view text, size_t start) {
+    if (expect == Expect::FirstKey || expect == Expect::Key) {
+        if (muted == 0) {
+            const JsonHandler::Action action = handler->key(text);
+            if (skips(action)) muteNext = true;
+            else handle(action);
+        }
+        expect = Expect::Colon;
+        return;
+    }
+    if (expect != Expect::Value && expect != Expect::FirstValue) unexpected(start);
+    if (reporting()) handle(handler->string(text));
+    completeValue();
+}
+
+// Integers are kept exact as int64, or uint64 past the int64 range, as by JsonParser
+void JsonPushParser::completeNumber(std::string_view text, size_t start, size_t end) {
+    JsonNumber number;
+    const char* message = nullptr;
+    size_t at = 0;
+    if (!JsonNumber::parse(text, number, message, at)) throw error(message, start + at);
+    checkScalarEnd(end);
+    if (expect != Expect::Value && expect != Expect::FirstValue) unexpected(start);
+
+    if (reporting()) {
+        int64_t signedValue = 0;
+        uint64_t unsignedValue = 0;
+        double num = 0.0;
+        if (number.toInt64(signedValue)) handle(handler->int64(signedValue));
+        else if (number.toUInt64(text, unsignedValue)) handle(handler->uint64(unsignedValue));
+        else if (number.toDouble(text, num)) handle(handler->number(num));
+        else throw error("Invalid number", start);
+    }
+    completeValue();
+}
+
+void JsonPushParser::completeLiteral(std::string_view text, size_t start, size_t end) {
+    if (text != "true" && text != "false" && text != "null") {
+        throw error("Unknown literal: " + string(text), start);
+    }
+    checkScalarEnd(end);
+    if (expect != Expect::Value && expect != Expect::FirstValue) unexpected(start);
+
+    if (reporting()) handle(text == "null" ? handler->null() : handler->boolean(text == "true"));
+    completeValue();
+}
+
+// An array element is about to start: ask the handler whether to report it
+void JsonPushParser::startValue() {
+    if (open.empty() || open.back() != '[' || muted > 0) return;
+    if (expect != Expect::Value && expect != Expect::FirstValue) return;
+    const JsonHandler::Action action = handler->element();
+    if (skips(action)) muteNext = true;
+    else handle(action);
+}
+
+void JsonPushParser::startContainer(char bracket, size_t offset) {
+    if (expect != Expect::Value && expect != Expect::FirstValue) unexpected(offset);
+
+    if (muted > 0) {
+        ++muted;
+    } else if (muteNext) {
+        muteNext = false;
+        muted = 1;
+    } else {
+        const JsonHandler::Action action = bracket == '{' ? handler->startObject() : handler->startArray();
+        if (skips(action)) muted = 1;
+        else handle(action);
+    }
+    open.push_back(bracket);
+    expect = bracket == '{' ? Expect::FirstKey : Expect::FirstValue;
+}
+
+void JsonPushParser::endContainer(char bracket, size_t offset) {
+    const bool object = bracket == '}';
+    const bool empty = object ? expect == Expect::FirstKey : expect == Expect::FirstValue;
+    const bool closes = expect == Expect::CommaOrEnd && open.back() == (object ? '{' : '[');
+    if (!empty && !closes) unexpected(offset);
+
+    open.pop_back();
+    // A skipped container's end is not reported, like its contents
+    if (muted > 0) --muted;
+    else handle(object ? handler->endObject() : handler->endArray());
+    completeValue();
+}
+
+void JsonPushParser::completeValue() {
+    expect = open.empty() ? Expect::Done : Expect::CommaOrEnd;
+}
+
+// Whether a scalar is reported: not inside a skipped container, nor the value of a skipped key
+bool JsonPushParser::reporting() {
+    if (muteNext) {
+        muteNext = false;
+        return false;
+    }
+    return muted == 0;
+}
+
+void JsonPushParser::handle(JsonHandler::Action action) {
+    if (action == JsonHandler::Action::Stop) stopped = true;
+}
+
+// ---- Errors ----
+// The same messages JsonParser gives for a token the grammar does not allow here
+void JsonPushParser::unexpected(size_t offset) const {
+    switch (expect) {
+        case Expect::FirstKey:
+        case Expect::Key:
+            throw error("Expected string key in object", offset);
+        case Expect::Colon:
+            throw error("Expected ':' after key", offset);
+        case Expect::CommaOrEnd:
+            throw error(open.back() == '{' ? "Expected '}' at end of object" : "Expected ']' at end of array", offset);
+        case Expect::Done:
+            throw error("Unexpected trailing content", offset);
+        default:
+            throw error("Unexpected token", offset);
+    }
+}
+
+// Offsets before the current piece can only be the start of a string, number or literal left
+// incomplete by an earlier one, which contains no newline
+JsonParseException JsonPushParser::error(const string& msg, size_t offset) const {
+    size_t line = lines + 1;
+    size_t start = lineStart;
+    if (offset > base) {
+        const std::string_view before = piece.substr(0, offset - base);
+        line += static_cast<size_t>(std::count(before.begin(), before.end(), '\n'));
+        const size_t newline = before.rfind('\n');
+        if (newline != std::string_view::npos) start = base + newline + 1;
+    }
+    return JsonParseException(msg, line, offset - start + 1);
+}
+
+}
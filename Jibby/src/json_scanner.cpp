@@ -0,0 +1,326 @@
+#include "json_scanner.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define JIBBY_SCANNER_X86 1
+    #include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+#if defined(JIBBY_SCANNER_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define JIBBY_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define JIBBY_TARGET_AVX2
+#endif
+
+using namespace std;
+
+namespace jibby {
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = 64;
+
+// One bit per byte of a 64-byte block, bit i describing byte i
+struct BlockMasks {
+    uint64_t whitespace = 0;
+    uint64_t quote = 0;
+    uint64_t backslash = 0;
+    uint64_t structural = 0;
+};
+
+// Kernels implemented once per instruction set
+struct Kernels {
+    void (*classify)(const char* block, BlockMasks& masks);
+    size_t (*skipWhitespace)(const char* data, size_t pos, size_t size);
+    size_t (*findStringSpecial)(const char* data, size_t pos, size_t size);
+};
+
+bool isStringSpecial(char c) {
+    return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+// ---- Scalar kernels ----
+void classifyScalar(const char* block, BlockMasks& masks) {
+    masks = BlockMasks{};
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        const uint64_t bit = uint64_t(1) << i;
+        const char c = block[i];
+        if (JsonScanner::isWhitespace(c)) masks.whitespace |= bit;
+        else if (c == '"') masks.quote |= bit;
+        else if (c == '\\') masks.backslash |= bit;
+        else if (JsonScanner::isStructural(c)) masks.structural |= bit;
+    }
+}
+
+size_t skipWhitespaceScalar(const char* data, size_t pos, size_t size) {
+    while (pos < size && JsonScanner::isWhitespace(data[pos])) ++pos;
+    return pos;
+}
+
+size_t findStringSpecialScalar(const char* data, size_t pos, size_t size) {
+    while (pos < size && !isStringSpecial(data[pos])) ++pos;
+    return pos;
+}
+
+const Kernels SCALAR_KERNELS = { classifyScalar, skipWhitespaceScalar, findStringSpecialScalar };
+
+#ifdef JIBBY_SCANNER_X86
+
+int countTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// ---- SSE2 kernels (baseline on x86-64) ----
+uint32_t sse2Eq(__m128i v, char c) {
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))));
+}
+
+uint32_t sse2Whitespace(__m128i v) {
+    return sse2Eq(v, ' ') | sse2Eq(v, '\n') | sse2Eq(v, '\r') | sse2Eq(v, '\t');
+}
+
+uint32_t sse2StringSpecial(__m128i v) {
+    // bytes <= 0x1F saturate to zero when 0x1F is subtracted
+    __m128i control = _mm_cmpeq_epi8(_mm_subs_epu8(v, _mm_set1_epi8(0x1F)), _mm_setzero_si128());
+    return sse2Eq(v, '"') | sse2Eq(v, '\\') | static_cast<uint32_t>(_mm_movemask_epi8(control));
+}
+
+void classifySse2(const char* block, BlockMasks& masks) {
+    masks = BlockMasks{};
+    for (int i = 0; i < 4; ++i) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        // '[' and ']' differ from '{' and '}' only in bit 0x20
+        const __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        const uint32_t structural = sse2Eq(folded, '{') | sse2Eq(folded, '}') | sse2Eq(v, ':') | sse2Eq(v, ',');
+        const int shift = 16 * i;
+        masks.whitespace |= uint64_t(sse2Whitespace(v)) << shift;
+        masks.quote |= uint64_t(sse2Eq(v, '"')) << shift;
+        masks.backslash |= uint64_t(sse2Eq(v, '\\')) << shift;
+        masks.structural |= uint64_t(structural) << shift;
+    }
+}
+
+size_t skipWhitespaceSse2(const char* data, size_t pos, size_t size) {
+    while (pos + 16 <= size) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const uint32_t other = ~sse2Whitespace(v) & 0xFFFF;
+        if (other) return pos + countTrailingZeros(other);
+        pos += 16;
+    }
+    return skipWhitespaceScalar(data, pos, size);
+}
+
+size_t findStringSpecialSse2(const char* data, size_t pos, size_t size) {
+    while (pos + 16 <= size) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const uint32_t special = sse2StringSpecial(v);
+        if (special) return pos + countTrailingZeros(special);
+        pos += 16;
+    }
+    return findStringSpecialScalar(data, pos, size);
+}
+
+const Kernels SSE2_KERNELS = { classifySse2, skipWhitespaceSse2, findStringSpecialSse2 };
+
+// ---- AVX2 kernels ----
+JIBBY_TARGET_AVX2 uint32_t avx2Eq(__m256i v, char c) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+}
+
+JIBBY_TARGET_AVX2 uint32_t avx2Whitespace(__m256i v) {
+    return avx2Eq(v, ' ') | avx2Eq(v, '\n') | avx2Eq(v, '\r') | avx2Eq(v, '\t');
+}
+
+JIBBY_TARGET_AVX2 void classifyAvx2(const char* block, BlockMasks& masks) {
+    masks = BlockMasks{};
+    for (int i = 0; i < 2; ++i) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * i));
+        const __m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        const uint32_t structural = avx2Eq(folded, '{') | avx2Eq(folded, '}') | avx2Eq(v, ':') | avx2Eq(v, ',');
+        const int shift = 32 * i;
+        masks.whitespace |= uint64_t(avx2Whitespace(v)) << shift;
+        masks.quote |= uint64_t(avx2Eq(v, '"')) << shift;
+        masks.backslash |= uint64_t(avx2Eq(v, '\\')) << shift;
+        masks.structural |= uint64_t(structural) << shift;
+    }
+}
+
+JIBBY_TARGET_AVX2 size_t skipWhitespaceAvx2(const char* data, size_t pos, size_t size) {
+    while (pos + 32 <= size) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        const uint32_t other = ~avx2Whitespace(v);
+        if (other) return pos + countTrailingZeros(other);
+        pos += 32;
+    }
+    return skipWhitespaceSse2(data, pos, size);
+}
+
+JIBBY_TARGET_AVX2 size_t findStringSpecialAvx2(const char* data, size_t pos, size_t size) {
+    while (pos + 32 <= size) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        const __m256i control = _mm256_cmpeq_epi8(_mm256_subs_epu8(v, _mm256_set1_epi8(0x1F)), _mm256_setzero_si256());
+        const uint32_t special = avx2Eq(v, '"') | avx2Eq(v, '\\') | static_cast<uint32_t>(_mm256_movemask_epi8(control));
+        if (special) return pos + countTrailingZeros(special);
+        pos += 32;
+    }
+    return findStringSpecialSse2(data, pos, size);
+}
+
+const Kernels AVX2_KERNELS = { classifyAvx2, skipWhitespaceAvx2, findStringSpecialAvx2 };
+
+bool cpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // JIBBY_SCANNER_X86
+
+JsonScanner::Isa detectIsa() {
+#ifdef JIBBY_SCANNER_X86
+    return cpuHasAvx2() ? JsonScanner::Isa::AVX2 : JsonScanner::Isa::SSE2;
+#else
+    return JsonScanner::Isa::Scalar;
+#endif
+}
+
+const Kernels& kernelsFor(JsonScanner::Isa isa) {
+    switch (isa) {
+#ifdef JIBBY_SCANNER_X86
+        case JsonScanner::Isa::AVX2: return AVX2_KERNELS;
+        case JsonScanner::Isa::SSE2: return SSE2_KERNELS;
+#endif
+        default:                     return SCALAR_KERNELS;
+    }
+}
+
+const JsonScanner::Isa SUPPORTED_ISA = detectIsa();
+std::atomic<JsonScanner::Isa> activeIsa{SUPPORTED_ISA};
+
+const Kernels& kernels() {
+    return kernelsFor(activeIsa.load(std::memory_order_relaxed));
+}
+
+// Running xor of the bits from the lowest up: bit i is set when an odd number of bits <= i are set
+uint64_t prefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// Bits of the characters escaped by a backslash. Runs of backslashes escape every other character,
+// so a run of odd length escapes the character after it. prevEscaped carries over between blocks
+uint64_t findEscaped(uint64_t backslash, uint64_t& prevEscaped) {
+    backslash &= ~prevEscaped;
+    const uint64_t followsEscape = backslash << 1 | prevEscaped;
+
+    const uint64_t evenBits = 0x5555555555555555ULL;
+    const uint64_t oddSequenceStarts = backslash & ~evenBits & ~followsEscape;
+    const uint64_t sequencesStartingOnEvenBits = oddSequenceStarts + backslash;
+    prevEscaped = sequencesStartingOnEvenBits < oddSequenceStarts ? 1 : 0;
+
+    const uint64_t invertMask = sequencesStartingOnEvenBits << 1;
+    return (evenBits ^ invertMask) & followsEscape;
+}
+
+} // namespace
+
+JsonScanner::Isa JsonScanner::isa() {
+    return activeIsa.load(std::memory_order_relaxed);
+}
+
+void JsonScanner::setIsa(Isa requested) {
+    activeIsa.store(std::min(requested, SUPPORTED_ISA), std::memory_order_relaxed);
+}
+
+size_t JsonScanner::skipWhitespace(std::string_view input, size_t pos) {
+    // Most runs of whitespace are empty or a single separator, keep those off the vector path
+    if (pos >= input.size() || !isWhitespace(input[pos])) return pos;
+    if (pos + 1 >= input.size() || !isWhitespace(input[pos + 1])) return pos + 1;
+    return kernels().skipWhitespace(input.data(), pos + 2, input.size());
+}
+
+size_t JsonScanner::findStringSpecial(std::string_view input, size_t pos) {
+    return kernels().findStringSpecial(input.data(), pos, input.size());
+}
+
+bool JsonScanner::nextWindow(vector<size_t>& index) {
+    index.clear();
+    if (pos >= input.size()) return false;
+
+    const Kernels& k = kernels();
+    const size_t end = std::min(input.size(), pos + WINDOW_SIZE);
+
+    for (; pos < end; pos += BLOCK_SIZE) {
+        BlockMasks masks;
+        if (pos + BLOCK_SIZE <= input.size()) {
+            k.classify(input.data() + pos, masks);
+        } else {
+            // Pad the final partial block with whitespace, which never starts a token
+            char padded[BLOCK_SIZE];
+            std::memset(padded, ' ', BLOCK_SIZE);
+            std::memcpy(padded, input.data() + pos, input.size() - pos);
+            k.classify(padded, masks);
+        }
+
+        // Quotes that open or close strings, and the bytes inside strings. The in-string mask
+        // covers the opening quote but not the closing one
+        const uint64_t escaped = findEscaped(masks.backslash, prevEscaped);
+        const uint64_t quote = masks.quote & ~escaped;
+        const uint64_t inString = prefixXor(quote) ^ prevInString;
+        prevInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+        const uint64_t stringTail = inString ^ quote;
+
+        // A scalar (number, literal or string) starts on any other character that does not
+        // directly follow a non-quote scalar character
+        const uint64_t scalar = ~(masks.structural | masks.whitespace);
+        const uint64_t nonQuoteScalar = scalar & ~quote;
+        const uint64_t followsNonQuoteScalar = nonQuoteScalar << 1 | prevScalar;
+        prevScalar = nonQuoteScalar >> 63;
+
+        uint64_t starts = (masks.structural | (scalar & ~followsNonQuoteScalar)) & ~stringTail;
+        while (starts) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long bit;
+            _BitScanForward64(&bit, starts);
+#else
+            const int bit = __builtin_ctzll(starts);
+#endif
+            const size_t offset = pos + static_cast<size_t>(bit);
+            if (offset >= input.size()) break;
+            index.push_back(offset);
+            starts &= starts - 1;
+        }
+    }
+
+    return true;
+}
+
+}
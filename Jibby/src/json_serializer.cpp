@@ -1,11 +1,22 @@
 #include "json_serializer.h"
+#include "json_writer.h"
 
 using namespace std; 
 
 namespace jibby {
 
 string JsonSerializer::serialize(const Json& value, int indent) {
-    return value.serialize(indent, 0);
+    string out;
+    JsonWriter(out).write(value, indent);
+    return out;
+}
+
+void JsonSerializer::serialize(const Json& value, string& out, int indent) {
+    JsonWriter(out).write(value, indent);
+}
+
+void JsonSerializer::serialize(const Json& value, std::ostream& out, int indent) {
+    JsonWriter(out).write(value, indent);
 }
 
 } 
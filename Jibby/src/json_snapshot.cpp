@@ -0,0 +1,335 @@
+#include "json_snapshot.h"
+#include "json_exception.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+using namespace std;
+
+namespace jibby {
+
+namespace {
+
+// Layout. All integers are little-endian and all offsets count from the first byte.
+//
+//   header   "JIBBYSNP", u32 version, u32 reserved, u64 total size, root slot
+//   slot     u8 kind, 3 bytes padding, u32 length, u64 payload
+//   array    length slots
+//   object   length members in insertion order, then length u32 member positions sorted by key
+//   member   u64 key offset, u32 key length, u32 padding, value slot
+//
+// The payload is the value of a number or boolean, or the offset of a string's bytes or a
+// container's block. Blocks start on 8-byte boundaries and always lie after the slot that refers
+// to them, so following offsets can never loop
+constexpr char MAGIC[8] = {'J', 'I', 'B', 'B', 'Y', 'S', 'N', 'P'};
+constexpr size_t ROOT_SLOT = 24;
+constexpr size_t HEADER_SIZE = ROOT_SLOT + 16;
+constexpr size_t SLOT_SIZE = 16;
+constexpr size_t MEMBER_SIZE = 32;
+constexpr size_t INDEX_ENTRY_SIZE = 4;
+
+enum Kind : uint8_t { NULL_VALUE, FALSE_VALUE, TRUE_VALUE, INT64, UINT64, DOUBLE, STRING, ARRAY, OBJECT };
+
+uint64_t load(std::string_view bytes, size_t offset, size_t width) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < width; ++i) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[offset + i])) << (8 * i);
+    }
+    return value;
+}
+
+void store(string& out, size_t offset, uint64_t value, size_t width) {
+    for (size_t i = 0; i < width; ++i) out[offset + i] = static_cast<char>(value >> (8 * i));
+}
+
+[[noreturn]] void corrupt(size_t offset) {
+    throw JsonException("Corrupt snapshot at byte " + to_string(offset));
+}
+
+uint32_t checkedLength(size_t length) {
+    if (length > numeric_limits<uint32_t>::max()) {
+        throw JsonException("Value too large for a snapshot: " + to_string(length));
+    }
+    return static_cast<uint32_t>(length);
+}
+
+// Builds a snapshot depth-first, filling in each slot once the block it refers to is reserved
+class SnapshotBuilder {
+    public:
+        explicit SnapshotBuilder(string& out) : out(out) {}
+
+        void value(size_t slot, const Json& json) {
+            if (json.isNull()) {
+                head(slot, NULL_VALUE, 0, 0);
+            } else if (json.isBoolean()) {
+                head(slot, json.asBoolean() ? TRUE_VALUE : FALSE_VALUE, 0, 0);
+            } else if (json.isInt64()) {
+                head(slot, INT64, 0, static_cast<uint64_t>(json.asInt64()));
+            } else if (json.isUInt64()) {
+                head(slot, UINT64, 0, json.asUInt64());
+            } else if (json.isNumber()) {
+                const double number = json.asNumber();
+                uint64_t bits;
+                std::memcpy(&bits, &number, sizeof(bits));
+                head(slot, DOUBLE, 0, bits);
+            } else if (json.isString()) {
+                const JsonString& str = json.asJsonString();
+                head(slot, STRING, checkedLength(str.size()), text(str));
+            } else if (json.isArray()) {
+                const Array& arr = json.asArray();
+                const size_t block = reserve(arr.size() * SLOT_SIZE);
+                head(slot, ARRAY, checkedLength(arr.size()), block);
+                for (size_t i = 0; i < arr.size(); ++i) value(block + i * SLOT_SIZE, arr[i]);
+            } else {
+                object(slot, json.asObject());
+            }
+        }
+
+    private:
+        string& out;
+
+        void head(size_t slot, uint8_t kind, uint32_t length, uint64_t payload) {
+            store(out, slot, kind, 1);
+            store(out, slot + 4, length, 4);
+            store(out, slot + 8, payload, 8);
+        }
+
+        // Zeroed space for a block at the next 8-byte boundary
+        size_t reserve(size_t size) {
+            const size_t offset = (out.size() + 7) & ~size_t(7);
+            out.resize(offset + size, '\0');
+            return offset;
+        }
+
+        // Strings are null-terminated as a convenience for C APIs
+        size_t text(std::string_view str) {
+            const size_t offset = out.size();
+            out.append(str.data(), str.size());
+            out.push_back('\0');
+            return offset;
+        }
+
+        void object(size_t slot, const Object& obj) {
+            const size_t count = obj.size();
+            const size_t block = reserve(count * (MEMBER_SIZE + INDEX_ENTRY_SIZE));
+            head(slot, OBJECT, checkedLength(count), block);
+
+            vector<std::string_view> keys;
+            keys.reserve(count);
+            for (const auto& [key, member] : obj) keys.push_back(key);
+            vector<uint32_t> order(count);
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+            for (size_t i = 0; i < count; ++i) {
+                store(out, block + count * MEMBER_SIZE + i * INDEX_ENTRY_SIZE, order[i], INDEX_ENTRY_SIZE);
+            }
+
+            size_t position = block;
+            for (const auto& [key, member] : obj) {
+                store(out, position, text(key), 8);
+                store(out, position + 8, checkedLength(key.size()), 4);
+                value(position + 16, member);
+                position += MEMBER_SIZE;
+            }
+        }
+};
+
+} // namespace
+
+// ---- JsonSnapshotValue ----
+
+uint8_t JsonSnapshotValue::kind() const {
+    return static_cast<uint8_t>(bytes[slot]);
+}
+
+uint64_t JsonSnapshotValue::payload() const {
+    return load(bytes, slot + 8, 8);
+}
+
+size_t JsonSnapshotValue::count() const {
+    return static_cast<size_t>(load(bytes, slot + 4, 4));
+}
+
+bool JsonSnapshotValue::isNull() const    { return kind() == NULL_VALUE; }
+bool JsonSnapshotValue::isBoolean() const { return kind() == FALSE_VALUE || kind() == TRUE_VALUE; }
+bool JsonSnapshotValue::isNumber() const  { return kind() == INT64 || kind() == UINT64 || kind() == DOUBLE; }
+bool JsonSnapshotValue::isString() const  { return kind() == STRING; }
+bool JsonSnapshotValue::isObject() const  { return kind() == OBJECT; }
+bool JsonSnapshotValue::isArray() const   { return kind() == ARRAY; }
+
+// Offset of this container's block, checked to lie after the slot and within the snapshot
+size_t JsonSnapshotValue::block(uint8_t expected, size_t stride) const {
+    const uint64_t offset = payload();
+    if (kind() != expected || offset <= slot || offset > bytes.size()
+        || count() > (bytes.size() - offset) / stride) {
+        corrupt(slot);
+    }
+    return static_cast<size_t>(offset);
+}
+
+std::string_view JsonSnapshotValue::text(size_t offset, size_t length) const {
+    if (offset > bytes.size() || length > bytes.size() - offset) corrupt(slot);
+    return bytes.substr(offset, length);
+}
+
+std::string_view JsonSnapshotValue::key(size_t block, size_t index) const {
+    const size_t member = block + index * MEMBER_SIZE;
+    return text(static_cast<size_t>(load(bytes, member, 8)), static_cast<size_t>(load(bytes, member + 8, 4)));
+}
+
+size_t JsonSnapshotValue::size() const {
+    if (!isObject() && !isArray()) throw JsonException("Json value is not an object or array");
+    return count();
+}
+
+// Binary search of the sorted member index
+std::optional<JsonSnapshotValue> JsonSnapshotValue::find(std::string_view name) const {
+    const size_t members = count();
+    const size_t start = block(OBJECT, MEMBER_SIZE + INDEX_ENTRY_SIZE);
+    const size_t index = start + members * MEMBER_SIZE;
+    size_t low = 0;
+    size_t high = members;
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        const size_t position = static_cast<size_t>(load(bytes, index + middle * INDEX_ENTRY_SIZE, INDEX_ENTRY_SIZE));
+        if (position >= members) corrupt(slot);
+        const int order = key(start, position).compare(name);
+        if (order == 0) return JsonSnapshotValue(bytes, start + position * MEMBER_SIZE + 16);
+        if (order < 0) low = middle + 1;
+        else high = middle;
+    }
+    return std::nullopt;
+}
+
+bool JsonSnapshotValue::contains(std::string_view name) const {
+    return isObject() && find(name).has_value();
+}
+
+JsonSnapshotValue JsonSnapshotValue::operator[](std::string_view name) const {
+    if (!isObject()) throw JsonException("Cannot use operator[] on non-object JSON value");
+    if (auto member = find(name)) return *member;
+    throw JsonException("Key not found: " + string(name));
+}
+
+JsonSnapshotValue JsonSnapshotValue::operator[](size_t index) const {
+    if (!isArray()) throw JsonException("Cannot use operator[] with index on non-array JSON value");
+    if (index >= count()) throw JsonException("Array index out of bounds: " + to_string(index));
+    return JsonSnapshotValue(bytes, block(ARRAY, SLOT_SIZE) + index * SLOT_SIZE);
+}
+
+std::string_view JsonSnapshotValue::asString() const {
+    if (!isString()) throw JsonException("Json value is not a string");
+    return text(static_cast<size_t>(payload()), count());
+}
+
+// Numbers, booleans and null as the Json they stand for, which allocates nothing
+Json JsonSnapshotValue::scalar() const {
+    const uint64_t bits = payload();
+    switch (kind()) {
+        case NULL_VALUE: return Json();
+        case FALSE_VALUE: return Json(false);
+        case TRUE_VALUE: return Json(true);
+        case INT64: return Json(static_cast<int64_t>(bits));
+        case UINT64: return Json(bits);
+        case DOUBLE: {
+            double number;
+            std::memcpy(&number, &bits, sizeof(number));
+            return Json(number);
+        }
+        default: corrupt(slot);
+    }
+}
+
+double JsonSnapshotValue::asNumber() const {
+    if (!isNumber()) throw JsonException("Json value is not a number");
+    return scalar().asNumber();
+}
+
+int64_t JsonSnapshotValue::asInt64() const {
+    if (!isNumber()) throw JsonException("Json value is not an int64 number");
+    return scalar().asInt64();
+}
+
+uint64_t JsonSnapshotValue::asUInt64() const {
+    if (!isNumber()) throw JsonException("Json value is not a uint64 number");
+    return scalar().asUInt64();
+}
+
+bool JsonSnapshotValue::asBoolean() const {
+    if (!isBoolean()) throw JsonException("Json value is not a boolean");
+    return kind() == TRUE_VALUE;
+}
+
+Json JsonSnapshotValue::toJson() const {
+    if (isString()) return Json(JsonString(asString()));
+    if (isArray()) {
+        block(ARRAY, SLOT_SIZE); // checks count() before reserving for it
+        Array arr;
+        arr.reserve(count());
+        for (const auto& element : *this) arr.push_back(element.second.toJson());
+        return Json(std::move(arr));
+    }
+    if (isObject()) {
+        block(OBJECT, MEMBER_SIZE + INDEX_ENTRY_SIZE);
+        Json obj = Json::object();
+        Object& members = obj.asObject();
+        members.reserve(count());
+        for (const auto& [name, member] : *this) members.insert_or_assign(name, member.toJson());
+        return obj;
+    }
+    return scalar();
+}
+
+JsonSnapshotValue::Iterator JsonSnapshotValue::begin() const {
+    if (!isObject() && !isArray()) throw JsonException("Cannot iterate over non-object/array JSON value");
+    return Iterator(bytes, slot, 0);
+}
+
+JsonSnapshotValue::Iterator JsonSnapshotValue::end() const {
+    return Iterator(bytes, slot, size());
+}
+
+std::pair<std::string_view, JsonSnapshotValue> JsonSnapshotValue::Iterator::operator*() const {
+    const JsonSnapshotValue container(bytes, slot);
+    if (container.isArray()) {
+        return {std::string_view(), JsonSnapshotValue(bytes, container.block(ARRAY, SLOT_SIZE) + position * SLOT_SIZE)};
+    }
+    const size_t start = container.block(OBJECT, MEMBER_SIZE + INDEX_ENTRY_SIZE);
+    return {container.key(start, position), JsonSnapshotValue(bytes, start + position * MEMBER_SIZE + 16)};
+}
+
+// ---- JsonSnapshot ----
+
+JsonSnapshot::JsonSnapshot(std::string_view snapshot) : bytes(snapshot) {
+    checkHeader();
+}
+
+JsonSnapshot::JsonSnapshot(JsonMappedFile&& mapped) : file(std::move(mapped)), bytes(file->text()) {
+    checkHeader();
+}
+
+void JsonSnapshot::checkHeader() const {
+    if (bytes.size() < HEADER_SIZE || std::memcmp(bytes.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        throw JsonException("Not a Jibby snapshot");
+    }
+    const uint64_t version = load(bytes, 8, 4);
+    if (version != VERSION) throw JsonException("Unsupported snapshot version: " + to_string(version));
+    if (load(bytes, 16, 8) != bytes.size()) throw JsonException("Truncated snapshot");
+}
+
+JsonSnapshotValue JsonSnapshot::root() const {
+    return JsonSnapshotValue(bytes, ROOT_SLOT);
+}
+
+string JsonSnapshot::encode(const Json& value) {
+    string out(HEADER_SIZE, '\0');
+    std::memcpy(&out[0], MAGIC, sizeof(MAGIC));
+    store(out, 8, VERSION, 4);
+    SnapshotBuilder(out).value(ROOT_SLOT, value);
+    out.resize((out.size() + 7) & ~size_t(7), '\0');
+    store(out, 16, out.size(), 8);
+    return out;
+}
+
+}
@@ -0,0 +1,131 @@
+#include "json_stats.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace jibby {
+
+namespace {
+
+// Sink adding each statistic to an object
+JsonMetricSink into(Json& out) {
+    return [&out](std::string_view name, double value) {
+        const bool whole = value >= 0.0 && value < 9.0e15 && value == static_cast<double>(static_cast<uint64_t>(value));
+        if (whole) out[name] = static_cast<uint64_t>(value);
+        else out[name] = value;
+    };
+}
+
+double count(size_t value) {
+    return static_cast<double>(value);
+}
+
+} // namespace
+
+// ---- JsonParseStats ----
+JsonParseStats& JsonParseStats::operator+=(const JsonParseStats& other) {
+    parses += other.parses;
+    bytes += other.bytes;
+    tokens += other.tokens;
+    objects += other.objects;
+    arrays += other.arrays;
+    members += other.members;
+    strings += other.strings;
+    stringBytes += other.stringBytes;
+    escapedStrings += other.escapedStrings;
+    unescapedBytes += other.unescapedBytes;
+    numbers += other.numbers;
+    literals += other.literals;
+    maxDepth = std::max(maxDepth, other.maxDepth);
+    allocations += other.allocations;
+    allocatedBytes += other.allocatedBytes;
+    seconds += other.seconds;
+    tokenizeSeconds += other.tokenizeSeconds;
+    return *this;
+}
+
+void JsonParseStats::report(const JsonMetricSink& sink) const {
+    sink("parses", count(parses));
+    sink("bytes", count(bytes));
+    sink("tokens", count(tokens));
+    sink("objects", count(objects));
+    sink("arrays", count(arrays));
+    sink("members", count(members));
+    sink("strings", count(strings));
+    sink("string_bytes", count(stringBytes));
+    sink("escaped_strings", count(escapedStrings));
+    sink("unescaped_bytes", count(unescapedBytes));
+    sink("numbers", count(numbers));
+    sink("literals", count(literals));
+    sink("max_depth", count(maxDepth));
+    sink("allocations", count(allocations));
+    sink("allocated_bytes", count(allocatedBytes));
+    sink("seconds", seconds);
+    if (timeTokenizer) {
+        sink("tokenize_seconds", tokenizeSeconds);
+        sink("build_seconds", std::max(0.0, seconds - tokenizeSeconds));
+    }
+}
+
+Json JsonParseStats::toJson() const {
+    Json out = Json::object();
+    report(into(out));
+    return out;
+}
+
+// ---- JsonWriteStats ----
+JsonWriteStats& JsonWriteStats::operator+=(const JsonWriteStats& other) {
+    writes += other.writes;
+    bytes += other.bytes;
+    objects += other.objects;
+    arrays += other.arrays;
+    members += other.members;
+    strings += other.strings;
+    stringBytes += other.stringBytes;
+    escapes += other.escapes;
+    numbers += other.numbers;
+    literals += other.literals;
+    maxDepth = std::max(maxDepth, other.maxDepth);
+    flushes += other.flushes;
+    seconds += other.seconds;
+    return *this;
+}
+
+void JsonWriteStats::report(const JsonMetricSink& sink) const {
+    sink("writes", count(writes));
+    sink("bytes", count(bytes));
+    sink("objects", count(objects));
+    sink("arrays", count(arrays));
+    sink("members", count(members));
+    sink("strings", count(strings));
+    sink("string_bytes", count(stringBytes));
+    sink("escapes", count(escapes));
+    sink("numbers", count(numbers));
+    sink("literals", count(literals));
+    sink("max_depth", count(maxDepth));
+    sink("flushes", count(flushes));
+    sink("seconds", seconds);
+}
+
+Json JsonWriteStats::toJson() const {
+    Json out = Json::object();
+    report(into(out));
+    return out;
+}
+
+// ---- JsonCountingResource ----
+void* JsonCountingResource::do_allocate(size_t bytes, size_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    byteCount.fetch_add(bytes, std::memory_order_relaxed);
+    return upstream->allocate(bytes, alignment);
+}
+
+void JsonCountingResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    upstream->deallocate(p, bytes, alignment);
+}
+
+bool JsonCountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+}
@@ -1,6 +1,5 @@
 #include "json_tokenizer.h"
-#include <cctype>      
-#include <sstream>     
+#include <algorithm>
 #include <stdexcept>  
 
 using namespace std;   
@@ -9,6 +8,18 @@ namespace jibby {
 
 namespace {
 
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool isAlpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+bool isNumberChar(char c) {
+    return isDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
 int hexValue(char c) {
     if (c >= '0' && c <= '9') return c - '0';
     if (c >= 'a' && c <= 'f') return 10 + (c - 'a');
@@ -29,212 +40,344 @@ void appendUtf8(string& out, unsigned codePoint) {
     }
 }
 
+// Decode the escapes of a string token's text, already validated by stringToken()
+void unescape(std::string_view raw, string& out) {
+    size_t pos = 0;
+    while (true) {
+        const size_t backslash = raw.find('\\', pos);
+        out.append(raw.data() + pos, std::min(backslash, raw.size()) - pos);
+        if (backslash == std::string_view::npos) return;
+
+        const char esc = raw[backslash + 1];
+        pos = backslash + 2;
+        switch (esc) {
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                unsigned codePoint = 0;
+                for (int i = 0; i < 4; ++i) {
+                    codePoint = (codePoint << 4) | static_cast<unsigned>(hexValue(raw[pos++]));
+                }
+                appendUtf8(out, codePoint);
+                break;
+            }
+            default: out.push_back(esc); break; // '"', '\\' and '/'
+        }
+    }
+}
+
 } // namespace
 
+JsonTokenizer::JsonTokenizer(JsonSource source, size_t chunkSize)
+    : scanner(std::string_view()), source(std::move(source)), chunkSize(chunkSize > 0 ? chunkSize : DEFAULT_CHUNK_SIZE) {}
+
+JsonTokenizer::JsonTokenizer(std::string_view document, size_t begin, size_t end)
+    : input(document.substr(begin, end - begin)), scanner(input), base(begin), preceding(document.substr(0, begin)) {}
+
 // Utility Methods 
+
+void JsonTokenizer::collect(JsonParseStats* target, const Token& last) {
+#if defined(JIBBY_STATS)
+    stats = target;
+    if (stats) count(last);
+#else
+    (void)target;
+    (void)last;
+#endif
+}
+
+void JsonTokenizer::count(const Token& token) {
+    switch (token.type) {
+        case TokenType::END_OF_FILE:
+            return;
+        case TokenType::STRING:
+            ++stats->strings;
+            stats->stringBytes += token.length;
+            if (token.escaped) {
+                ++stats->escapedStrings;
+                stats->unescapedBytes += text(token).size();
+            }
+            break;
+        case TokenType::NUMBER:
+            ++stats->numbers;
+            break;
+        case TokenType::TRUE:
+        case TokenType::FALSE:
+        case TokenType::NUL:
+            ++stats->literals;
+            break;
+        default:
+            break;
+    }
+    ++stats->tokens;
+}
+
+const JsonNumber& JsonTokenizer::numberValue() const {
+    return number;
+}
+
+// Strings with escapes are only decoded here, so those that are skipped are never decoded
+std::string_view JsonTokenizer::text(const Token& token) const {
+    const std::string_view raw = input.substr(token.offset, token.length);
+    if (!token.escaped) return raw;
+    scratch.clear();
+    unescape(raw, scratch);
+    return scratch;
+}
 
-bool JsonTokenizer::isAtEnd() const {
-    return pos >= input.size();
+void JsonTokenizer::locate(size_t offset, size_t& line, size_t& column) const {
+    offset = std::min(offset, input.size());
+    size_t linesBefore = droppedLines;
+    size_t firstLineStart = droppedLineStart;
+    if (!preceding.empty()) {
+        linesBefore += static_cast<size_t>(std::count(preceding.begin(), preceding.end(), '\n'));
+        const size_t newline = preceding.rfind('\n');
+        firstLineStart = newline == std::string_view::npos ? 0 : newline + 1;
+    }
+    line = 1 + linesBefore + static_cast<size_t>(std::count(input.begin(), input.begin() + offset, '\n'));
+    size_t newline = offset == 0 ? std::string_view::npos : input.rfind('\n', offset - 1);
+    size_t lineStart = newline == std::string_view::npos ? firstLineStart : base + newline + 1;
+    column = base + offset - lineStart + 1;
 }
 
-char JsonTokenizer::peek() const {
+JsonParseException JsonTokenizer::error(const string& msg, size_t offset) const {
+    size_t line = 1;
+    size_t column = 1;
+    locate(offset, line, column);
+    return JsonParseException(msg, line, column);
+}
+
+bool JsonTokenizer::isAtEnd() {
+    return pos >= input.size() && !fill();
+}
+
+char JsonTokenizer::peek() {
     if (isAtEnd()) return '\0';
     return input[pos];
 }
 
-char JsonTokenizer::advance() {
-    if (isAtEnd()) return '\0';
+// Append the next chunk of streamed input. Returns false at the end of the input
+bool JsonTokenizer::fill() {
+    if (!source) return false;
+    const size_t used = buffer.size();
+    buffer.resize(used + chunkSize);
+    const size_t received = source(&buffer[used], chunkSize);
+    buffer.resize(used + std::min(received, chunkSize));
+    input = buffer;
+    return received > 0;
+}
 
-    char c = input[pos++];
-    if (c == '\n') {
-        line++;
-        column = 1;
-    } else {
-        column++;
+// Drop the streamed text before pos, keeping count of its lines for error locations
+void JsonTokenizer::compact() {
+    const std::string_view dropped = input.substr(0, pos);
+    const size_t newline = dropped.rfind('\n');
+    if (newline != std::string_view::npos) {
+        droppedLines += static_cast<size_t>(std::count(dropped.begin(), dropped.end(), '\n'));
+        droppedLineStart = base + newline + 1;
     }
-    return c;
+    buffer.erase(0, pos);
+    base += pos;
+    pos = 0;
+    input = buffer;
 }
 
-void JsonTokenizer::skipWhitespace() {
-    while (!isAtEnd()) {
-        char c = peek();
-        if (isspace(static_cast<unsigned char>(c))) {
-            advance();
-        } else {
-            break;
+// Offset of the next token start in streamed input, once at least a chunk has been read past
+// the text still in the buffer
+size_t JsonTokenizer::nextStreamed() {
+    if (pos >= chunkSize) compact();
+    while (true) {
+        pos = JsonScanner::skipWhitespace(input, pos);
+        if (pos < input.size() || !fill()) return pos;
+    }
+}
+
+// Offset of the next token start in the structural index, pulling in the next window as needed
+size_t JsonTokenizer::nextStructural() {
+    while (cursor == index.size()) {
+        if (!scanner.nextWindow(index)) return input.size();
+        cursor = 0;
+    }
+    return index[cursor++];
+}
+
+bool JsonTokenizer::skipContainer(char open) {
+    if (source) return false;
+    // Brackets still open, innermost last
+    string brackets(1, open);
+    while (true) {
+        const size_t offset = nextStructural();
+        if (offset >= input.size()) {
+            // Unclosed: the parser reports the end of input where it expects the bracket
+            pos = input.size();
+            return true;
         }
+        const char c = input[offset];
+        if (c == '{' || c == '[') {
+            brackets.push_back(c);
+        } else if (c == '}' || c == ']') {
+            if (brackets.back() != (c == '}' ? '{' : '[')) throw error("Mismatched bracket", offset);
+            brackets.pop_back();
+            if (brackets.empty()) {
+                pos = offset + 1;
+                return true;
+            }
+        }
+    }
+}
+
+// The index only records scalars that start after whitespace or structure, so a number or
+// literal must be followed by one of those for the next token to be in the index
+void JsonTokenizer::expectScalarEnd() {
+    if (isAtEnd()) return;
+    char c = peek();
+    if (!JsonScanner::isWhitespace(c) && !JsonScanner::isStructural(c)) {
+        throw error("Unexpected character: " + string(1, c), pos);
     }
 }
 
 // Main Tokenizer Method 
 Token JsonTokenizer::getNextToken() {
-    skipWhitespace();
+    const Token token = readToken();
+    JIBBY_STAT(stats, count(token));
+    return token;
+}
+
+Token JsonTokenizer::readToken() {
+    pos = source ? nextStreamed() : nextStructural();
 
     if (isAtEnd()) {
-        return Token(TokenType::END_OF_FILE, "", line, column);
+        return Token(TokenType::END_OF_FILE, pos, 0);
     }
 
-    char c = advance();
+    char c = input[pos++];
 
     // Single-character tokens
     switch (c) {
-        case '{': return Token(TokenType::LEFT_BRACE, "{", line, column - 1);
-        case '}': return Token(TokenType::RIGHT_BRACE, "}", line, column - 1);
-        case '[': return Token(TokenType::LEFT_BRACKET, "[", line, column - 1);
-        case ']': return Token(TokenType::RIGHT_BRACKET, "]", line, column - 1);
-        case ':': return Token(TokenType::COLON, ":", line, column - 1);
-        case ',': return Token(TokenType::COMMA, ",", line, column - 1);
-        case '"': return stringToken();
+        case '{': return Token(TokenType::LEFT_BRACE, pos - 1, 1);
+        case '}': return Token(TokenType::RIGHT_BRACE, pos - 1, 1);
+        case '[': return Token(TokenType::LEFT_BRACKET, pos - 1, 1);
+        case ']': return Token(TokenType::RIGHT_BRACKET, pos - 1, 1);
+        case ':': return Token(TokenType::COLON, pos - 1, 1);
+        case ',': return Token(TokenType::COMMA, pos - 1, 1);
+        case '"': return stringToken(pos);
     }
 
     // Numbers 
-    if (isdigit(static_cast<unsigned char>(c)) || c == '-') {
-        return numberToken(c);
+    if (isDigit(c) || c == '-') {
+        Token token = numberToken(pos - 1);
+        expectScalarEnd();
+        return token;
     }
 
     // Literals (true, false, null)
-    if (isalpha(static_cast<unsigned char>(c))) {
-        return literalToken(c);
+    if (isAlpha(c)) {
+        Token token = literalToken(pos - 1);
+        expectScalarEnd();
+        return token;
     }
 
     // Unexpected character 
-    throw JsonParseException("Unexpected character: " + string(1, c), line, column - 1);
+    throw error("Unexpected character: " + string(1, c), pos - 1);
 }
 
-// String Tokens
-Token JsonTokenizer::stringToken() {
-    size_t startLine = line;
-    size_t startColumn = column;
+// String Tokens. Runs of plain characters are skipped in bulk up to the next quote, backslash
+// or control character
+Token JsonTokenizer::stringToken(size_t start) {
+    bool escaped = false;
 
-    string result;
+    while (true) {
+        pos = JsonScanner::findStringSpecial(input, pos);
+        if (pos == input.size()) {
+            // Streamed strings can continue in the next chunk
+            if (fill()) continue;
+            break;
+        }
 
-    while (!isAtEnd()) {
-        char c = advance();
+        char c = input[pos++];
         if (c == '"') {
             // End of string
-            return Token(TokenType::STRING, result, startLine, startColumn);
+            Token token(TokenType::STRING, start, pos - 1 - start);
+            token.escaped = escaped;
+            return token;
         }
 
-        // Handle escape sequences
+        // Escape sequences are validated here, and decoded by text() if the string is read
         if (c == '\\') {
-            if (isAtEnd()) throw JsonParseException("Unterminated string escape sequence", line, column);
+            escaped = true;
+            if (isAtEnd()) throw error("Unterminated string escape sequence", pos);
 
-            char esc = advance();
+            char esc = input[pos++];
             switch (esc) {
-                case '"':  result.push_back('"');  break;
-                case '\\': result.push_back('\\'); break;
-                case '/':  result.push_back('/');  break;
-                case 'b':  result.push_back('\b'); break;
-                case 'f':  result.push_back('\f'); break;
-                case 'n':  result.push_back('\n'); break;
-                case 'r':  result.push_back('\r'); break;
-                case 't':  result.push_back('\t'); break;
+                case '"':
+                case '\\':
+                case '/':
+                case 'b':
+                case 'f':
+                case 'n':
+                case 'r':
+                case 't':
+                    break;
                 case 'u': {
-                    unsigned codePoint = 0;
                     for (int i = 0; i < 4; ++i) {
                         if (isAtEnd()) {
-                            throw JsonParseException("Unterminated unicode escape", line, column);
+                            throw error("Unterminated unicode escape", pos);
                         }
 
-                        char hex = advance();
-                        int value = hexValue(hex);
-                        if (value < 0) {
-                            throw JsonParseException("Invalid unicode escape", line, column - 1);
+                        if (hexValue(input[pos++]) < 0) {
+                            throw error("Invalid unicode escape", pos - 1);
                         }
-                        codePoint = (codePoint << 4) | static_cast<unsigned>(value);
                     }
-                    appendUtf8(result, codePoint);
                     break;
                 }
                 default:
-                    throw JsonParseException("Invalid escape character: " + string(1, esc), line, column - 1);
+                    throw error("Invalid escape character: " + string(1, esc), pos - 1);
             }
         } else {
-            if (static_cast<unsigned char>(c) < 0x20) {
-                throw JsonParseException("Unescaped control character in string", line, column - 1);
-            }
-            result.push_back(c);
+            throw error("Unescaped control character in string", pos - 1);
         }
     }
 
-    throw JsonParseException("Unterminated string literal", startLine, startColumn);
+    throw error("Unterminated string literal", start);
 }
 
-// Number Tokens 
-Token JsonTokenizer::numberToken(char firstChar) {
-    size_t startLine = line;
-    size_t startColumn = column - 1;
-
-    string numStr;
-    numStr.push_back(firstChar);
-
-    if (firstChar == '-') {
-        if (isAtEnd() || !isdigit(static_cast<unsigned char>(peek()))) {
-            throw JsonParseException("Invalid number", startLine, startColumn);
-        }
-        numStr.push_back(advance());
+// Number Tokens. The extent of the number is found first, then it is validated and decomposed
+// in one pass
+Token JsonTokenizer::numberToken(size_t start) {
+    pos = start;
+    while (true) {
+        while (pos < input.size() && isNumberChar(input[pos])) ++pos;
+        // Streamed numbers can continue in the next chunk
+        if (pos < input.size() || !fill()) break;
     }
 
-    if (numStr.back() == '0') {
-        if (!isAtEnd() && isdigit(static_cast<unsigned char>(peek()))) {
-            throw JsonParseException("Leading zeroes are not allowed", line, column);
-        }
-    } else {
-        while (!isAtEnd() && isdigit(static_cast<unsigned char>(peek()))) {
-            numStr.push_back(advance());
-        }
+    const char* message = nullptr;
+    size_t at = 0;
+    if (!JsonNumber::parse(input.substr(start, pos - start), number, message, at)) {
+        throw error(message, start + at);
     }
-
-    if (!isAtEnd() && peek() == '.') {
-        numStr.push_back(advance());
-        if (isAtEnd() || !isdigit(static_cast<unsigned char>(peek()))) {
-            throw JsonParseException("Invalid number", line, column);
-        }
-        while (!isAtEnd() && isdigit(static_cast<unsigned char>(peek()))) {
-            numStr.push_back(advance());
-        }
+    if (!isAtEnd() && isAlpha(peek())) {
+        throw error("Invalid number", pos);
     }
 
-    if (!isAtEnd() && (peek() == 'e' || peek() == 'E')) {
-        numStr.push_back(advance());
-        if (!isAtEnd() && (peek() == '+' || peek() == '-')) {
-            numStr.push_back(advance());
-        }
-        if (isAtEnd() || !isdigit(static_cast<unsigned char>(peek()))) {
-            throw JsonParseException("Invalid exponent", line, column);
-        }
-        while (!isAtEnd() && isdigit(static_cast<unsigned char>(peek()))) {
-            numStr.push_back(advance());
-        }
-    }
-
-    if (!isAtEnd()) {
-        char c = peek();
-        if (isalpha(static_cast<unsigned char>(c)) || c == '.' || c == '+' || c == '-') {
-            throw JsonParseException("Invalid number", line, column);
-        }
-    }
-
-    return Token(TokenType::NUMBER, numStr, startLine, startColumn);
+    return Token(TokenType::NUMBER, start, pos - start);
 }
 
 // Literal Tokens (true, false, null) 
-Token JsonTokenizer::literalToken(char firstChar) {
-    size_t startLine = line;
-    size_t startColumn = column - 1;
-
-    string literal(1, firstChar);
+Token JsonTokenizer::literalToken(size_t start) {
+    pos = start;
 
     // Collect full literal
-    while (!isAtEnd() && isalpha(static_cast<unsigned char>(peek()))) {
-        literal.push_back(advance());
-    }
+    while (isAlpha(peek())) ++pos;
 
-    if (literal == "true")  return Token(TokenType::TRUE, literal, startLine, startColumn);
-    if (literal == "false") return Token(TokenType::FALSE, literal, startLine, startColumn);
-    if (literal == "null")  return Token(TokenType::NUL, literal, startLine, startColumn);
+    std::string_view literal = input.substr(start, pos - start);
+    if (literal == "true")  return Token(TokenType::TRUE, start, literal.size());
+    if (literal == "false") return Token(TokenType::FALSE, start, literal.size());
+    if (literal == "null")  return Token(TokenType::NUL, start, literal.size());
 
-    throw JsonParseException("Unknown literal: " + literal, startLine, startColumn);
+    throw error("Unknown literal: " + string(literal), start);
 }
 
 } // namespace jibby
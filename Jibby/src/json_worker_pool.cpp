@@ -0,0 +1,61 @@
+#include "json_worker_pool.h"
+
+using namespace std;
+
+namespace jibby {
+
+namespace {
+
+// Pool whose task the thread is running, if any
+thread_local const JsonWorkerPool* currentPool = nullptr;
+
+}
+
+JsonWorkerPool::JsonWorkerPool(size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([this] { run(); });
+    }
+}
+
+JsonWorkerPool::~JsonWorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+std::future<void> JsonWorkerPool::submit(std::function<void()> task) {
+    std::packaged_task<void()> packaged(std::move(task));
+    std::future<void> result = packaged.get_future();
+    if (currentPool == this) {
+        packaged();
+        return result;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(packaged));
+    }
+    available.notify_one();
+    return result;
+}
+
+void JsonWorkerPool::run() {
+    currentPool = this;
+    while (true) {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+}
@@ -0,0 +1,212 @@
+#include "json_writer.h"
+#include "json_number.h"
+#include "json_scanner.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+
+using namespace std;
+
+namespace jibby {
+
+JsonWriter::JsonWriter(string& out) : target(&out) {}
+
+JsonWriter::JsonWriter(std::ostream& out) : target(&staging), stream(&out) {
+    staging.reserve(BUFFER_SIZE);
+}
+
+JsonWriter::JsonWriter(char* buffer, size_t size) : fixed(buffer), capacity(size) {}
+
+JsonWriter::~JsonWriter() {
+    flush();
+}
+
+void JsonWriter::collect(JsonWriteStats& target) {
+#if defined(JIBBY_STATS)
+    stats = &target;
+#else
+    (void)target;
+#endif
+}
+
+void JsonWriter::flush() {
+    if (stream && !staging.empty()) {
+        JIBBY_STAT(stats, ++stats->flushes);
+        stream->write(staging.data(), static_cast<std::streamsize>(staging.size()));
+        staging.clear();
+    }
+}
+
+// ---- Output ----
+void JsonWriter::append(const char* data, size_t length) {
+    written += length;
+    if (target) {
+        target->append(data, length);
+        if (stream && staging.size() >= BUFFER_SIZE) flush();
+        return;
+    }
+
+    // Fixed buffer: keep what fits and remember that the rest was dropped
+    const size_t used = written - length;
+    if (used < capacity) {
+        std::memcpy(fixed + used, data, std::min(length, capacity - used));
+    }
+    if (written > capacity) overflow = true;
+}
+
+void JsonWriter::append(char c) {
+    if (target && !stream) {
+        ++written;
+        target->push_back(c);
+        return;
+    }
+    append(&c, 1);
+}
+
+void JsonWriter::appendSpaces(size_t count) {
+    static const char spaces[] = "                                                                ";
+    while (count > 0) {
+        const size_t chunk = std::min(count, sizeof(spaces) - 1);
+        append(spaces, chunk);
+        count -= chunk;
+    }
+}
+
+void JsonWriter::newline(int indent, int depth) {
+    append('\n');
+    appendSpaces(static_cast<size_t>(indent) * static_cast<size_t>(depth));
+}
+
+// ---- Serialization ----
+void JsonWriter::write(const Json& value, int indent, int depth) {
+#if defined(JIBBY_STATS)
+    if (stats) {
+        const auto start = chrono::steady_clock::now();
+        const size_t before = written;
+        level = 0;
+        writeValue(value, indent, depth);
+        if (stream) flush();
+        ++stats->writes;
+        stats->bytes += written - before;
+        stats->seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return;
+    }
+#endif
+    writeValue(value, indent, depth);
+    if (stream) flush();
+}
+
+void JsonWriter::writeValue(const Json& value, int indent, int depth) {
+    switch (value.type) {
+        case Json::Type::Null:
+            JIBBY_STAT(stats, ++stats->literals);
+            append("null");
+            break;
+        case Json::Type::Boolean:
+            JIBBY_STAT(stats, ++stats->literals);
+            append(get<bool>(value.value) ? std::string_view("true") : std::string_view("false"));
+            break;
+        case Json::Type::Number:
+            JIBBY_STAT(stats, ++stats->numbers);
+            writeNumber(value);
+            break;
+        case Json::Type::String:
+            writeString(get<JsonString>(value.value));
+            break;
+
+        case Json::Type::Object: {
+            const auto& obj = get<Object>(value.value);
+            JIBBY_STAT(stats, {
+                ++stats->objects;
+                stats->members += obj.size();
+                stats->maxDepth = std::max(stats->maxDepth, ++level);
+            });
+            append('{');
+            bool first = true;
+            for (const auto& [key, val] : obj) {
+                if (!first) append(',');
+                if (indent > 0) newline(indent, depth + 1);
+                writeString(key);
+                append(": ");
+                writeValue(val, indent, depth + 1);
+                first = false;
+            }
+            if (indent > 0 && !obj.empty()) newline(indent, depth);
+            append('}');
+            JIBBY_STAT(stats, --level);
+            break;
+        }
+
+        case Json::Type::Array: {
+            const auto& arr = get<Array>(value.value);
+            JIBBY_STAT(stats, {
+                ++stats->arrays;
+                stats->maxDepth = std::max(stats->maxDepth, ++level);
+            });
+            append('[');
+            bool first = true;
+            for (const auto& val : arr) {
+                if (!first) append(',');
+                if (indent > 0) newline(indent, depth + 1);
+                writeValue(val, indent, depth + 1);
+                first = false;
+            }
+            if (indent > 0 && !arr.empty()) newline(indent, depth);
+            append(']');
+            JIBBY_STAT(stats, --level);
+            break;
+        }
+    }
+}
+
+void JsonWriter::writeNumber(const Json& value) {
+    char buffer[JsonNumber::MAX_DOUBLE_LENGTH];
+    if (auto i = get_if<int64_t>(&value.value)) {
+        append(buffer, static_cast<size_t>(to_chars(buffer, buffer + sizeof(buffer), *i).ptr - buffer));
+    } else if (auto u = get_if<uint64_t>(&value.value)) {
+        append(buffer, static_cast<size_t>(to_chars(buffer, buffer + sizeof(buffer), *u).ptr - buffer));
+    } else {
+        append(buffer, JsonNumber::formatDouble(get<double>(value.value), buffer));
+    }
+}
+
+// Quoted and escaped string. Runs that need no escaping are copied in one go; the scanner finds
+// the next quote, backslash or control character
+void JsonWriter::writeString(std::string_view text) {
+    static const char* hex = "0123456789abcdef";
+    JIBBY_STAT(stats, {
+        ++stats->strings;
+        stats->stringBytes += text.size();
+    });
+    append('"');
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const size_t special = JsonScanner::findStringSpecial(text, pos);
+        append(text.data() + pos, special - pos);
+        if (special == text.size()) break;
+
+        const unsigned char c = static_cast<unsigned char>(text[special]);
+        JIBBY_STAT(stats, ++stats->escapes);
+        switch (c) {
+            case '\"': append("\\\""); break;
+            case '\\': append("\\\\"); break;
+            case '\b': append("\\b"); break;
+            case '\f': append("\\f"); break;
+            case '\n': append("\\n"); break;
+            case '\r': append("\\r"); break;
+            case '\t': append("\\t"); break;
+            default: {
+                const char escaped[] = { '\\', 'u', '0', '0', hex[(c >> 4) & 0x0F], hex[c & 0x0F] };
+                append(escaped, sizeof(escaped));
+                break;
+            }
+        }
+        pos = special + 1;
+    }
+
+    append('"');
+}
+
+}
@@ -1,12 +1,37 @@
 #include "json.h"
+#include "json_binary.h"
+#include "json_document.h"
 #include "json_exception.h"
+#include "json_io.h"
+#include "json_lazy.h"
+#include "json_lines_reader.h"
+#include "json_mapped_file.h"
 #include "json_parser.h"
+#include "json_pointer.h"
+#include "json_projection.h"
+#include "json_push_parser.h"
+#include "json_scanner.h"
+#include "json_serializer.h"
+#include "json_snapshot.h"
+#include "json_stats.h"
+#include "json_writer.h"
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <memory_resource>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 using jibby::Json;
 using jibby::JsonException;
@@ -38,13 +63,29 @@ void testLoadAndSaveRoundTrip() {
 
     data["complete"] = true;
 
-    const std::filesystem::path outPath = std::filesystem::path("tests") / "config_out.json";
+    const std::filesystem::path outPath = std::filesystem::temp_directory_path() / "jibby_config_out.json";
     data.save(outPath.string(), true);
 
     Json reloaded = Json::load(outPath.string());
+    std::filesystem::remove(outPath);
     assert(reloaded["complete"].asBoolean() == true);
 }
 
+void testStringAccessors() {
+    Json value = "a string long enough to need the heap";
+
+    // asString() views the stored string in place; asJsonString() is the string itself, to modify
+    const std::string_view view = value.asString();
+    assert(view.data() == value.asJsonString().data() && view == "a string long enough to need the heap");
+    const std::string copy(value.asString());
+    value.asJsonString() += "_copy";
+    assert(copy == "a string long enough to need the heap");
+    assert(value.asString() == "a string long enough to need the heap_copy");
+
+    expectThrows([] { Json(1).asString(); }, "not a string", "testStringAccessors");
+    expectThrows([] { Json(1).asJsonString(); }, "not a string", "testStringAccessors");
+}
+
 void testRejectsTrailingContent() {
     expectThrows([] {
         JsonParser parser("{\"ok\":true}[]");
@@ -88,14 +129,1068 @@ void testRejectsInvalidStringsAndNumbers() {
     }, "Invalid exponent", "testRejectsInvalidStringsAndNumbers/exponent");
 }
 
+void testParsesCallerOwnedBuffer() {
+    const std::string text = "{\"plain\":\"abc\",\"escaped\":\"a\\tb\\u00e9\",\"list\":[1,2]} trailing";
+    Json parsed = JsonParser(text.data(), text.find(" trailing")).parse();
+    assert(parsed["plain"].asString() == "abc");
+    assert(parsed["escaped"].asString() == "a\tb\xC3\xA9");
+    assert(parsed["list"][1].asNumber() == 2);
+
+    std::string owned = "[\"moved\"]";
+    assert(JsonParser(std::move(owned)).parse()[0].asString() == "moved");
+}
+
+void testScannerKernelsAgree() {
+    // Strings with backslash runs and quotes straddling 64-byte block boundaries, separated
+    // by whitespace runs of every length
+    std::string text = "[";
+    std::vector<std::string> expected;
+    for (size_t i = 0; i < 200; ++i) {
+        std::string raw(i % 70, 'x');
+        std::string value = raw;
+        for (size_t k = 0; k < i % 5; ++k) {
+            raw += "\\\\\\\"";
+            value += "\\\"";
+        }
+        if (i > 0) text += ",";
+        text += std::string(i % 37, i % 2 ? ' ' : '\n');
+        text += "\"" + raw + "\"";
+        expected.push_back(value);
+    }
+    text += "]";
+
+    const auto supported = jibby::JsonScanner::isa();
+    for (auto isa : {jibby::JsonScanner::Isa::Scalar, jibby::JsonScanner::Isa::SSE2, jibby::JsonScanner::Isa::AVX2}) {
+        jibby::JsonScanner::setIsa(isa);
+        Json parsed = JsonParser(text).parse();
+        assert(parsed.asArray().size() == expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            assert(std::string_view(parsed[i].asJsonString()) == expected[i]);
+        }
+    }
+    jibby::JsonScanner::setIsa(supported);
+}
+
+void testReportsErrorLocation() {
+    expectThrows([] {
+        JsonParser parser("{\n  \"a\": tru\n}");
+        parser.parse();
+    }, "Unknown literal: tru (line 2, column 8)", "testReportsErrorLocation/literal");
+
+    expectThrows([] {
+        JsonParser parser("[1,\n 2x]");
+        parser.parse();
+    }, "(line 2, column 3)", "testReportsErrorLocation/scalar-end");
+}
+
+void testNumbersRoundTripExactly() {
+    const double samples[] = {0.1, 1.0 / 3.0, 123456789.0, 5e-324, 1.7976931348623157e308, 2.2250738585072014e-308,
+                              -273.15, 6.02214076e23, 9007199254740993.0, 0.30000000000000004};
+    for (double sample : samples) {
+        char text[64];
+        std::snprintf(text, sizeof(text), "[%.17g]", sample);
+        assert(JsonParser(text).parse()[0].asNumber() == sample);
+    }
+
+    assert(JsonParser("[0.1000000000000000055511151231257827021181583404541015625]").parse()[0].asNumber() == 0.1);
+    assert(JsonParser("[1e-400]").parse()[0].asNumber() == 0.0);
+    assert(std::signbit(JsonParser("[-0]").parse()[0].asNumber()));
+
+    expectThrows([] {
+        JsonParser parser("[1e400]");
+        parser.parse();
+    }, "Invalid number", "testNumbersRoundTripExactly/overflow");
+}
+
+void testIntegersStayExact() {
+    Json parsed = JsonParser("[9007199254740993, -9223372036854775808, 18446744073709551615, 18446744073709551616, 7, 7.0]").parse();
+    assert(parsed[0].isInt64() && parsed[0].asInt64() == 9007199254740993LL);
+    assert(parsed[1].isInt64() && parsed[1].asInt64() == INT64_MIN);
+    assert(!parsed[2].isInt64() && parsed[2].isUInt64() && parsed[2].asUInt64() == UINT64_MAX);
+    assert(!parsed[3].isInteger() && parsed[3].asNumber() == 18446744073709551616.0);
+    assert(parsed[4].isUInt64() && parsed[4].asNumber() == 7);
+    assert(!parsed[5].isInteger());
+    assert(parsed.serialize().find("[9007199254740993,-9223372036854775808,18446744073709551615,") == 0);
+
+    expectThrows([&] { parsed[1].asUInt64(); }, "not a uint64", "testIntegersStayExact/uint64");
+
+    Json value = Json::object();
+    value["id"] = 12345678901234567890ULL;
+    value["delta"] = -5;
+    assert(value["id"].asUInt64() == 12345678901234567890ULL);
+    assert(value["delta"].asInt64() == -5);
+    value["delta"].asNumber() += 0.5;
+    assert(!value["delta"].isInteger() && value["delta"].asNumber() == -4.5);
+}
+
+void testDoublesSerializeShortestRoundTrip() {
+    Json values = Json::array();
+    for (double sample : {123456789.0, 0.1, 1.0 / 3.0, -0.0, 1e21, 5e-324, 2.5}) {
+        values.asArray().push_back(Json(sample));
+    }
+    values.asArray().push_back(Json(std::nan("")));
+
+    const std::string text = values.serialize();
+    assert(text == "[123456789.0,0.1,0.3333333333333333,-0.0,1e+21,5e-324,2.5,null]");
+
+    Json reparsed = JsonParser(text).parse();
+    for (size_t i = 0; i + 1 < values.asArray().size(); ++i) {
+        assert(!reparsed[i].isInteger());
+        assert(reparsed[i].asNumber() == values[i].asNumber());
+    }
+    assert(std::signbit(reparsed[3].asNumber()));
+}
+
+void testWriterSinks() {
+    Json value = JsonParser("{\"list\":[1,\"two\",null,{\"k\":\"tab\\there\"}]}").parse();
+    const std::string expected = value.serialize(2);
+
+    std::string appended = "prefix:";
+    jibby::JsonWriter(appended).write(value, 2);
+    assert(appended == "prefix:" + expected);
+
+    std::ostringstream streamed;
+    jibby::JsonSerializer::serialize(value, streamed, 2);
+    assert(streamed.str() == expected);
+
+    std::vector<char> buffer(expected.size());
+    jibby::JsonWriter exact(buffer.data(), buffer.size());
+    exact.write(value, 2);
+    assert(!exact.overflowed() && std::string(buffer.begin(), buffer.end()) == expected);
+
+    jibby::JsonWriter small(buffer.data(), 8);
+    small.write(value, 2);
+    assert(small.overflowed() && small.size() == expected.size());
+}
+
+// Memory resource that counts allocations, to check where Json values allocate from
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t allocations = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+void testDocumentAllocatesFromArena() {
+    static_assert(std::is_nothrow_move_constructible_v<Json>, "arrays must move, not copy, their elements");
+
+    std::string text = "[";
+    for (int i = 0; i < 1000; ++i) {
+        if (i > 0) text += ",";
+        text += "{\"name\":\"a string long enough to need the heap " + std::to_string(i) + "\",\"tags\":[1,2,3]}";
+    }
+    text += "]";
+
+    CountingResource heap;
+    std::pmr::memory_resource* previous = std::pmr::set_default_resource(&heap);
+
+    jibby::JsonDocument document(1024);
+    for (int round = 0; round < 3; ++round) {
+        Json& root = document.parse(text);
+        assert(root.asArray().size() == 1000);
+        assert(std::string_view(root[999]["name"].asJsonString()) == "a string long enough to need the heap 999");
+    }
+    assert(heap.allocations == 0);
+
+    Json copy = document.root()[5];
+    document.clear();
+    assert(heap.allocations > 0);
+    assert(std::string_view(copy["name"].asString()) == "a string long enough to need the heap 5");
+
+    // A copy out of the document is on the heap and outlives it; a moved value stays in the arena
+    document.parse(text);
+    Json kept = document.root()[7]["name"];
+    Json moved = std::move(document.root()[8]["name"]);
+    assert(kept.asJsonString().get_allocator().resource() == std::pmr::get_default_resource());
+    assert(moved.asJsonString().get_allocator().resource() == document.resource());
+    moved = Json();
+    document.parse("[]");
+    assert(kept.asString() == "a string long enough to need the heap 7");
+
+    std::pmr::set_default_resource(previous);
+}
+
+void testObjectsKeepInsertionOrder() {
+    Json parsed = JsonParser("{\"zeta\":1,\"alpha\":2,\"mid\":3,\"alpha\":4}").parse();
+    assert(parsed.serialize() == "{\"zeta\": 1,\"alpha\": 4,\"mid\": 3}");
+
+    // Grow past the index threshold and check lookups on both sides of it
+    jibby::Object obj;
+    const size_t count = jibby::Object::INDEX_THRESHOLD * 4;
+    for (size_t i = 0; i < count; ++i) {
+        obj["key" + std::to_string(i)] = static_cast<int64_t>(i);
+        for (size_t j = 0; j <= i; j += 7) {
+            assert(obj.find("key" + std::to_string(j))->second.asInt64() == static_cast<int64_t>(j));
+        }
+        assert(obj.find("missing") == obj.end());
+    }
+
+    // Erasing keeps the remaining members in order and findable, down through the threshold
+    for (size_t i = 0; i < count; i += 2) assert(obj.erase("key" + std::to_string(i)) == 1);
+    size_t expected = 1;
+    for (const auto& [key, val] : obj) {
+        assert(std::string_view(key) == "key" + std::to_string(expected) && val.asInt64() == static_cast<int64_t>(expected));
+        assert(obj.find(key) != obj.end());
+        expected += 2;
+    }
+    assert(obj.size() == count / 2 && obj.count("key0") == 0);
+
+    // Keys are read-only through iterators, as the index is built from them; values are not
+    static_assert(std::is_const_v<std::remove_reference_t<decltype(obj.begin()->first)>>);
+    static_assert(!std::is_const_v<std::remove_reference_t<decltype(obj.begin()->second)>>);
+    jibby::Object::const_iterator first = obj.begin();
+    obj.begin()->second = "changed";
+    assert(first->second.asString() == "changed" && obj.find(first->first) == obj.begin());
+    assert(obj.erase(first) == obj.begin() && std::string_view(obj.begin()->first) == "key3");
+}
+
+void testKeysAreInterned() {
+    const std::string text = "[{\"id\":1,\"ts\":2,\"value\":3},{\"id\":4,\"ts\":5,\"value\":6},{\"value\":7,\"id\":8}]";
+
+    jibby::JsonKeyPool keys;
+    Json records = JsonParser(text, keys).parse();
+    assert(keys.size() == 3);
+
+    // Every record refers to the pool's copy of each key
+    const auto& first = records[0].asObject().begin()->first;
+    const auto& last = (records[2].asObject().begin() + 1)->first;
+    assert(first.isInterned() && first == "id" && last.data() == first.data());
+    assert(records[2].asObject().find(keys.intern("id"))->second.asInt64() == 8);
+    assert(records[1]["value"].asInt64() == 6);
+
+    // Copies own their keys, so they outlive the pool
+    Json copy = records[1];
+    keys.clear();
+    assert(!copy.asObject().begin()->first.isInterned());
+    assert(copy.serialize() == "{\"id\": 4,\"ts\": 5,\"value\": 6}");
+
+    jibby::JsonDocument document;
+    document.parse(text);
+    assert(document.keyCount() == 3 && document.root()[2]["id"].asInt64() == 8);
+    document.clearKeys();
+    assert(document.keyCount() == 0 && document.root().isNull());
+
+    // Keys that never repeat, such as ids, are forgotten once there are more than maxKeys
+    jibby::JsonDocument byId(1024, 100);
+    for (int round = 0; round < 20; ++round) {
+        std::string ids = "{";
+        for (int i = 0; i < 30; ++i) ids += (i > 0 ? ",\"" : "\"") + std::to_string(round * 30 + i) + "\":1";
+        byId.parse(ids + "}");
+        assert(byId.keyCount() <= 130 && byId.root().asObject().size() == 30);
+    }
+}
+
+// Sums the "value" members of records, skipping "detail" subtrees and stopping at a "stop" key
+class SummingHandler : public jibby::JsonHandler {
+public:
+    int64_t total = 0;
+    int events = 0;
+
+    Action key(std::string_view name) override {
+        ++events;
+        summing = name == "value";
+        if (name == "detail") return Action::Skip;
+        return name == "stop" ? Action::Stop : Action::Continue;
+    }
+    Action int64(int64_t value) override {
+        ++events;
+        if (summing) total += value;
+        return Action::Continue;
+    }
+    Action startObject() override { ++events; return Action::Continue; }
+    Action string(std::string_view) override { ++events; return Action::Continue; }
+
+private:
+    bool summing = false;
+};
+
+// Sums the int64 elements of an array, skipping every other one before it is decoded
+class EvenElementsHandler : public jibby::JsonHandler {
+public:
+    int64_t total = 0;
+    size_t elements = 0;
+
+    Action element() override { return elements++ % 2 == 0 ? Action::Continue : Action::SkipUnchecked; }
+    Action int64(int64_t value) override { total += value; return Action::Continue; }
+};
+
+void testHandlerEvents() {
+    SummingHandler sum;
+    assert(JsonParser("[{\"value\":1,\"detail\":{\"value\":100}},{\"name\":\"x\",\"value\":2}]").parse(sum));
+    assert(sum.total == 3 && sum.events == 9);
+
+    SummingHandler stopped;
+    assert(!JsonParser("[{\"value\":1},{\"stop\":true},{\"value\":2}] trailing").parse(stopped));
+    assert(stopped.total == 1);
+
+    // Skipped and handled input is validated just like the DOM parse
+    expectThrows([] {
+        SummingHandler handler;
+        JsonParser("{\"detail\":{\"a\" 1}}").parse(handler);
+    }, "Expected ':' after key", "testHandlerEvents");
+    expectThrows([] {
+        SummingHandler handler;
+        JsonParser("[1,2] 3").parse(handler);
+    }, "Unexpected trailing content", "testHandlerEvents");
+
+    // Elements skipped from element() are not converted, so a number out of range passes there
+    const std::string elements = "[1, 1e400, 3, [1e400], 5]";
+    EvenElementsHandler even;
+    assert(JsonParser(elements).parse(even) && even.total == 9 && even.elements == 5);
+    EvenElementsHandler pushed;
+    jibby::JsonPushParser pusher(pushed);
+    for (char c : elements) pusher.feed(&c, 1);
+    assert(pusher.finish() && pushed.total == 9 && pushed.elements == 5);
+    expectThrows([] { JsonParser("[1e400]").parse(); }, "Invalid number", "testHandlerEvents");
+}
+
+void testStreamsAcrossChunks() {
+    std::string text = "{\"name\": \"chunk \\\"boundaries\\\" \\u00e9\", \"values\": [1, -2.5e3, 18446744073709551615, true, null],\n";
+    text += " \"nested\": {\"empty\": {}, \"list\": []}, \"long\": \"" + std::string(300, 'x') + "\"}";
+    const std::string expected = JsonParser(text).parse().serialize();
+
+    for (size_t chunk : {1, 2, 3, 7, 64, 4096}) {
+        std::istringstream in(text);
+        assert(JsonParser(in, chunk).parse().serialize() == expected);
+    }
+
+    // Any source of bytes works, here handing out three at a time
+    size_t offset = 0;
+    JsonParser pulled([&](char* buffer, size_t capacity) {
+        const size_t count = std::min({capacity, size_t(3), text.size() - offset});
+        text.copy(buffer, count, offset);
+        offset += count;
+        return count;
+    }, 5);
+    assert(pulled.parse().serialize() == expected);
+
+    std::istringstream streamed(text);
+    assert(jibby::JsonIO::read(streamed).serialize() == expected);
+
+    // Error locations count the lines of input already dropped
+    expectThrows([] {
+        std::istringstream in("[1,\n2,\n3,\n  4x]");
+        JsonParser(in, 2).parse();
+    }, "(line 4, column 4)", "testStreamsAcrossChunks");
+}
+
+// Records the first string value seen
+class FirstStringHandler : public jibby::JsonHandler {
+public:
+    std::string_view first;
+
+    Action string(std::string_view value) override {
+        if (first.empty()) first = value;
+        return Action::Continue;
+    }
+};
+
+void testReadsMappedFiles() {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "jibby_mapped_test.json";
+    const std::string text = "{\"name\": \"mapped\", \"values\": [1, 2.5, \"three\"]}";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << text;
+    }
+
+    assert(jibby::JsonIO::readMapped(path.string()).serialize() == JsonParser(text).parse().serialize());
+    assert(Json::load(path.string())["name"].asString() == "mapped");
+
+    jibby::JsonMappedFile file(path.string());
+    assert(file.text() == text && file.isMapped() == jibby::JsonMappedFile::supported());
+
+    // Unescaped strings are handed out as views into the file itself
+    jibby::JsonMappedFile moved(std::move(file));
+    FirstStringHandler handler;
+    JsonParser(moved.text()).parse(handler);
+    assert(handler.first == "mapped");
+    assert(handler.first.data() >= moved.text().data() && handler.first.data() < moved.text().data() + moved.size());
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc).close();
+    assert(jibby::JsonMappedFile(path.string()).size() == 0);
+    std::filesystem::remove(path);
+
+    expectThrows([&] {
+        jibby::JsonIO::readMapped(path.string());
+    }, "Failed to open file for reading", "testReadsMappedFiles");
+}
+
+void testReadsRecordsInParallel() {
+    // Enough records for many batches, with blank lines and CRLF endings mixed in
+    std::string lines;
+    for (int i = 0; i < 40000; ++i) {
+        lines += "{\"id\": " + std::to_string(i) + ", \"tags\": [\"a\", \"b\"]}" + (i % 3 == 0 ? "\r\n" : "\n");
+        if (i % 1000 == 0) lines += "  \n";
+    }
+
+    jibby::JsonWorkerPool pool(3);
+    jibby::JsonLinesReader reader(lines, jibby::JsonLinesReader::Format::Lines, &pool);
+    size_t count = 0;
+    assert(reader.forEach([&](size_t index, Json& record) {
+        assert(index == count && record["id"].asNumber() == static_cast<double>(count));
+        ++count;
+        return true;
+    }));
+    assert(count == 40000);
+
+    // Stopping early
+    count = 0;
+    assert(!reader.forEach([&](size_t, Json&) { return ++count < 10; }));
+    assert(count == 10);
+
+    const std::string concatenated = "{\"a\": [1, {\"b\": \"}\"}]}[2]\n\"three\" 4 true{}";
+    std::vector<std::string> values;
+    jibby::JsonLinesReader(concatenated, jibby::JsonLinesReader::Format::Concatenated, &pool)
+        .forEach([&](size_t, Json& record) {
+            values.push_back(record.serialize());
+            return true;
+        });
+    assert((values == std::vector<std::string>{"{\"a\": [1,{\"b\": \"}\"}]}", "[2]", "\"three\"", "4", "true", "{}"}));
+
+    // Readers called from the pool's own tasks run their batches inline rather than waiting
+    // on the queue behind themselves, even with a single thread
+    jibby::JsonWorkerPool single(1);
+    size_t nested = 0;
+    single.submit([&] {
+        jibby::JsonLinesReader(lines, jibby::JsonLinesReader::Format::Lines, &single)
+            .forEach([&](size_t, Json&) { return ++nested != 0; });
+        const Json parsed = JsonParser("[[1], [2], [3]]").parseParallel(&single);
+        assert(parsed[2][0].asInt64() == 3);
+    }).get();
+    assert(nested == 40000);
+
+    // Bad records are reported where they are in the whole text, and can be skipped
+    const std::string broken = "[1]\n[2,]\n\n{\"x\": tru}\n[4]\n";
+    expectThrows([&] {
+        jibby::JsonLinesReader(broken, jibby::JsonLinesReader::Format::Lines, &pool)
+            .forEach([](size_t, Json&) { return true; });
+    }, "(line 2, column 4)", "testReadsRecordsInParallel");
+
+    std::vector<size_t> good;
+    std::vector<size_t> bad;
+    jibby::JsonLinesReader(broken, jibby::JsonLinesReader::Format::Lines, &pool).forEach(
+        [&](size_t index, Json&) { good.push_back(index); return true; },
+        [&](size_t index, const jibby::JsonParseException& error) {
+            bad.push_back(index);
+            return std::string(error.what()).find("line 4") != std::string::npos || index == 1;
+        });
+    assert((good == std::vector<size_t>{0, 3}) && (bad == std::vector<size_t>{1, 2}));
+}
+
+std::string parseError(const std::function<Json()>& parse) {
+    try {
+        parse();
+    } catch (const jibby::JsonParseException& ex) {
+        return ex.what();
+    }
+    return "";
+}
+
+void testParsesLargeArrayInParallel() {
+    std::string text = "[\n";
+    for (int i = 0; i < 30000; ++i) {
+        text += "  {\"id\": " + std::to_string(i) + ", \"list\": [1, [2, \"],\"]], \"o\": {}},\n";
+    }
+    text += "  \"last\"\n]\n";
+    assert(text.size() > JsonParser::PARALLEL_THRESHOLD);
+
+    jibby::JsonWorkerPool pool(3);
+    const Json parsed = JsonParser(text).parseParallel(&pool);
+    assert(parsed.serialize() == JsonParser(text).parse().serialize());
+    assert(parsed.asArray().size() == 30001 && parsed[29999]["id"].asNumber() == 29999);
+
+    // Errors inside elements, between them or around the array match the sequential parser's
+    auto breakAt = [&](const std::string& from, const std::string& to) {
+        std::string broken = text;
+        broken.replace(broken.rfind(from), from.size(), to);
+        return broken;
+    };
+    for (const std::string& broken : {breakAt("\"id\": 29000", "\"id\": 29000x"), breakAt("}},", "}} x,"),
+                                      breakAt("}},", "}},,"), breakAt("\"last\"\n", ""), breakAt("]\n", "] 5"),
+                                      breakAt("]\n", ""), breakAt("]\n", "}")}) {
+        const std::string expected = parseError([&] { return JsonParser(broken).parse(); });
+        assert(!expected.empty());
+        assert(parseError([&] { return JsonParser(broken).parseParallel(&pool); }) == expected);
+    }
+
+    // The same split is available element by element
+    std::vector<std::string> elements;
+    for (const char* small : {"[]", " [ ] ", "[1, [2, 3], {\"a\": \"[,]\"}]"}) {
+        jibby::JsonLinesReader(small, jibby::JsonLinesReader::Format::Elements, &pool).forEach([&](size_t, Json& element) {
+            elements.push_back(element.serialize());
+            return true;
+        });
+    }
+    assert((elements == std::vector<std::string>{"1", "[2,3]", "{\"a\": \"[,]\"}"}));
+}
+
+void testLazyDocumentDecodesOnDemand() {
+    const std::string text = R"({"id": 7, "user": {"name": "ada", "tags\u0021": ["x", "y"], "score": -2.5e1},
+        "items": [{"price": 10}, {"price": 20, "sku": "b\n"}], "ok": true, "none": null, "id": 8})";
+    jibby::JsonLazyDocument document(text);
+    const jibby::JsonLazyValue root = document.root();
+    assert(document.materializedCount() == 0);
+
+    assert(root.isObject() && root.size() == 6 && root["id"].asInt64() == 8);
+    assert(root["user"]["name"].asString() == "ada" && root["user"]["score"].asNumber() == -25.0);
+    assert(root["user"]["tags!"][1].asString() == "y" && root["user"].contains("tags!"));
+    assert(root["items"][1]["sku"].asString() == "b\n" && root["ok"].asBoolean() && root["none"].isNull());
+    // Only the scalars read were decoded, once each
+    assert(document.materializedCount() == 5);
+    assert(root["user"]["name"].asString().data() == root["user"]["name"].asString().data());
+
+    int total = 0;
+    for (auto [key, item] : root["items"]) {
+        assert(key.empty());
+        total += static_cast<int>(item["price"].asNumber());
+    }
+    assert(total == 30);
+    std::vector<std::string_view> keys;
+    for (auto [key, value] : root["user"]) keys.push_back(key);
+    assert((keys == std::vector<std::string_view>{"name", "tags!", "score"}));
+
+    assert(root["items"].json().serialize() == JsonParser(text).parse()["items"].serialize());
+    assert(root["user"]["tags!"].raw() == R"(["x", "y"])");
+
+    expectThrows([&] { root["missing"]; }, "Key not found: missing", "testLazyDocumentDecodesOnDemand");
+    expectThrows([&] { root["items"][2]; }, "Array index out of bounds", "testLazyDocumentDecodesOnDemand");
+    expectThrows([&] { root["ok"].asString(); }, "not a string", "testLazyDocumentDecodesOnDemand");
+    // The whole text is still validated up front
+    expectThrows([] { jibby::JsonLazyDocument("{\"a\": [1, 2,]}"); }, "(line 1, column 13)", "testLazyDocumentDecodesOnDemand");
+    expectThrows([] { jibby::JsonLazyDocument("[1] 2"); }, "Unexpected trailing content", "testLazyDocumentDecodesOnDemand");
+
+    jibby::JsonLazyDocument scalar(std::string(" 42 "));
+    assert(scalar.root().asUInt64() == 42);
+}
+
+void testProjectsPaths() {
+    const std::string text = R"({"user": {"id": 7, "name": "ada", "a/b": 1, "bio": "x\u0041\"]}["},
+        "items": [{"price": 10, "sku": "a"}, {"sku": "b"}, {"price": 30, "extra": [[{}], "]"]}],
+        "tags": ["x", "y", "z"], "meta": {"deep": {"er": [1, 2, 3]}}, "id": 1})";
+
+    const Json projected = JsonParser(text).parse(jibby::JsonProjection{"/user/id", "/items/*/price", "/tags/1", "/meta", "/user/a~1b"});
+    assert(projected.serialize() == R"({"user": {"id": 7,"a/b": 1},"items": [{"price": 10},{},{"price": 30}],"tags": [null,"y"],"meta": {"deep": {"er": [1,2,3]}}})");
+
+    // Elements keep their indices, so every requested path resolves in the result as in the
+    // whole document. Elements before a kept one are null, those after it dropped
+    const Json whole = JsonParser(text).parse();
+    for (const char* path : {"/user/id", "/items/0/price", "/items/2/price", "/tags/1", "/meta", "/user/a~1b"}) {
+        const jibby::JsonPointer pointer(path);
+        assert(projected.find(pointer) != nullptr && projected.find(pointer)->serialize() == whole.find(pointer)->serialize());
+    }
+    const Json sparse = JsonParser(text).parse(jibby::JsonProjection{"/items/2/extra/1", "/tags/2"});
+    assert(sparse.serialize() == R"({"items": [null,null,{"extra": [null,"]"]}],"tags": [null,null,"z"]})");
+    assert(sparse.find(jibby::JsonPointer("/items/2/extra/1"))->asString() == "]");
+
+    // The empty path keeps everything; no paths keep only the root container
+    assert(JsonParser(text).parse(jibby::JsonProjection{""}).serialize() == JsonParser(text).parse().serialize());
+    assert(JsonParser(text).parse(jibby::JsonProjection()).serialize() == "{}");
+
+    // Skipped members and elements are not decoded, so numbers out of range pass there
+    const std::string huge = R"({"a": [1, 1e400, "\u00e9"], "b": 1e400})";
+    assert(JsonParser(huge).parse(jibby::JsonProjection{"/a/0"}).serialize() == R"({"a": [1]})");
+    std::istringstream hugeIn(huge);
+    assert(JsonParser(hugeIn, 4).parse(jibby::JsonProjection{"/a/0"}).serialize() == R"({"a": [1]})");
+    expectThrows([&] {
+        JsonParser(huge).parse(jibby::JsonProjection{"/a/1"});
+    }, "Invalid number (line 1, column 11)", "testProjectsPaths");
+
+    // Kept values are still validated; skipped ones only have to be balanced
+    expectThrows([] {
+        JsonParser(R"({"a": [1, 2,], "b": 01})").parse(jibby::JsonProjection{"/b"});
+    }, "Leading zeroes are not allowed (line 1, column 22)", "testProjectsPaths");
+    expectThrows([] {
+        JsonParser(R"({"a": [1, {"b": 2}, "b": 3})").parse(jibby::JsonProjection{"/b"});
+    }, "Mismatched bracket (line 1, column 27)", "testProjectsPaths");
+    expectThrows([] {
+        JsonParser(R"({"a": [1}, "b": 2})").parse(jibby::JsonProjection{"/b"});
+    }, "Mismatched bracket (line 1, column 9)", "testProjectsPaths");
+    expectThrows([] {
+        JsonParser(R"({"a": {"x": [1, {"y": 1]}], "b": 2})").parse(jibby::JsonProjection{"/b"});
+    }, "Mismatched bracket (line 1, column 24)", "testProjectsPaths");
+    expectThrows([] {
+        jibby::JsonProjection{"user"};
+    }, "JSON Pointer", "testProjectsPaths");
+
+    // Streamed input has no structural index to skip with, and validates as it goes
+    std::istringstream in(text);
+    assert(JsonParser(in, 16).parse(jibby::JsonProjection{"/user/id", "/items/*/price", "/tags/1", "/meta", "/user/a~1b"}).serialize()
+           == projected.serialize());
+}
+
+void testResolvesJsonPointers() {
+    // Examples from RFC 6901
+    Json doc = JsonParser(R"({"foo": ["bar", "baz"], "": 0, "a/b": 1, "c%d": 2, "e^f": 3, "g|h": 4,
+        "i\\j": 5, "k\"l": 6, " ": 7, "m~n": 8})").parse();
+    assert(doc.at(jibby::JsonPointer("")).isObject());
+    assert(doc.at(jibby::JsonPointer("/foo")).asArray().size() == 2);
+    assert(doc.at(jibby::JsonPointer("/foo/0")).asString() == "bar");
+    const std::vector<std::pair<const char*, int>> members = {{"/", 0}, {"/a~1b", 1}, {"/c%d", 2}, {"/e^f", 3},
+        {"/g|h", 4}, {"/i\\j", 5}, {"/k\"l", 6}, {"/ ", 7}, {"/m~0n", 8}};
+    for (const auto& [pointer, expected] : members) {
+        assert(doc.at(jibby::JsonPointer(pointer)).asInt64() == expected);
+    }
+
+    // One compiled pointer against many documents, without throwing on a miss
+    const jibby::JsonPointer price("/items/1/price");
+    assert(price.size() == 3 && price.index(1) == 1 && price.segment(2) == "price");
+    assert(JsonParser(R"({"items": [{}, {"price": 5}]})").parse().find(price)->asNumber() == 5);
+    assert(JsonParser(R"({"items": [{}]})").parse().find(price) == nullptr);
+    assert(JsonParser(R"({"items": {"1": {"price": 6}}})").parse().find(price)->asNumber() == 6);
+    assert(JsonParser("[1]").parse().find(price) == nullptr);
+    assert(doc.find(jibby::JsonPointer("/foo/-")) == nullptr && doc.find(jibby::JsonPointer("/foo/01")) == nullptr);
+
+    // Mutable resolution, and the plain non-throwing lookups
+    doc.at(jibby::JsonPointer("/foo/1")) = "qux";
+    assert(doc["foo"][1].asString() == "qux");
+    assert(doc.find("foo") != nullptr && doc.find("nope") == nullptr && doc.contains("m~n"));
+    assert(doc["foo"].find(1) != nullptr && doc["foo"].find(2) == nullptr && doc.find(0) == nullptr);
+    const jibby::JsonKey key("a/b");
+    assert(doc.find(key)->asInt64() == 1);
+
+    expectThrows([&] { doc.at(jibby::JsonPointer("/foo/2")); }, "has no value at segment 1: 2", "testResolvesJsonPointers");
+    expectThrows([] { jibby::JsonPointer("foo"); }, "must be empty or start with '/'", "testResolvesJsonPointers");
+    expectThrows([] { jibby::JsonPointer("/a~2"); }, "Invalid escape", "testResolvesJsonPointers");
+}
+
+void testEncodesBinaryFormats() {
+    using jibby::JsonBinaryFormat;
+    const Json doc = JsonParser(R"({"name": "widget", "id": 9007199254740993, "neg": -42, "big": 18446744073709551615,
+        "ratio": 0.5, "pi": 3.141592653589793, "ok": true, "none": null, "tags": ["a", "", "é"],
+        "nested": {"empty": {}, "list": [[], [1, [2, [3]]]]}})").parse();
+    for (JsonBinaryFormat format : {JsonBinaryFormat::MessagePack, JsonBinaryFormat::Cbor}) {
+        const std::string bytes = doc.toBinary(format);
+        assert(bytes.size() < doc.serialize().size());
+        const Json back = Json::fromBinary(bytes, format);
+        assert(back.serialize() == doc.serialize());
+        assert(back["id"].asInt64() == 9007199254740993 && back["big"].asUInt64() == UINT64_MAX);
+    }
+
+    // Known encodings
+    assert(JsonParser(R"({"a": 1})").parse().toBinary() == "\x81\xa1" "a\x01");
+    assert(JsonParser(R"({"a": 1})").parse().toBinary(JsonBinaryFormat::Cbor) == "\xa1\x61" "a\x01");
+    assert(Json(-1).toBinary() == "\xff" && Json(-1).toBinary(JsonBinaryFormat::Cbor) == "\x20");
+    assert(Json(0.5).toBinary() == std::string("\xca\x3f\x00\x00\x00", 5));
+    assert(JsonParser("[300]").parse().toBinary() == "\x91\xcd\x01\x2c");
+
+    // CBOR the encoder never writes: indefinite lengths, a tag, a byte string, a half float
+    const std::string cbor("\x9f\xc1\x1a\x00\x00\x00\x01\x42hi\xf9\x3c\x00\xf7\xff", 15);
+    assert(Json::fromBinary(cbor, JsonBinaryFormat::Cbor).serialize() == R"([1,"hi",1.0,null])");
+
+    // A sequence of values through streams
+    std::stringstream stream;
+    {
+        jibby::JsonBinaryWriter writer(stream, JsonBinaryFormat::Cbor);
+        for (int i = 0; i < 3; ++i) writer.write(Json(i));
+        writer.write(doc);
+    }
+    jibby::JsonBinaryReader reader(stream, JsonBinaryFormat::Cbor);
+    for (int i = 0; i < 3; ++i) assert(reader.read().asInt64() == i);
+    assert(!reader.atEnd() && reader.read().serialize() == doc.serialize() && reader.atEnd());
+
+    // Stream output is staged until a chunk fills or the writer flushes
+    std::stringstream staged;
+    jibby::JsonBinaryWriter writer(staged, JsonBinaryFormat::MessagePack);
+    writer.write(Json(1));
+    assert(staged.str().empty());
+    writer.flush();
+    assert(staged.str() == "\x01");
+
+    // A stream that fails is an error, not the end of the input
+    struct FailingBuffer : std::streambuf {
+        int_type underflow() override { throw std::runtime_error("device gone"); }
+    } failing;
+    std::istream broken(&failing);
+    jibby::JsonBinaryReader brokenReader(broken, JsonBinaryFormat::Cbor);
+    expectThrows([&] { brokenReader.atEnd(); }, "Error while reading input stream", "testEncodesBinaryFormats");
+
+    // A long chain of tags is not nested, and a huge length on a stream reserves nothing like it
+    std::string tagged(2000000, '\xc1');
+    tagged += '\x01';
+    assert(Json::fromBinary(tagged, JsonBinaryFormat::Cbor).asInt64() == 1);
+    std::stringstream claimed(std::string("\x9b\x00\x00\x00\x00\xff\xff\xff\xff\x01", 10));
+    expectThrows([&] { jibby::JsonBinaryReader(claimed, JsonBinaryFormat::Cbor).read(); }, "unexpected end of input",
+                 "testEncodesBinaryFormats");
+
+    expectThrows([] { Json::fromBinary("\x92\x01"); }, "unexpected end of input", "testEncodesBinaryFormats");
+    expectThrows([] { Json::fromBinary("\x81\x01\x02"); }, "Invalid MessagePack", "testEncodesBinaryFormats");
+    expectThrows([] { Json::fromBinary("\x01\x02"); }, "trailing bytes", "testEncodesBinaryFormats");
+    expectThrows([] { Json::fromBinary("\x1c", JsonBinaryFormat::Cbor); }, "Invalid CBOR", "testEncodesBinaryFormats");
+}
+
+void testReadsSnapshots() {
+    const Json doc = JsonParser(R"({"name": "snapshot", "id": -7, "big": 18446744073709551615, "ratio": 0.25,
+        "ok": false, "none": null, "zeta": [1, "two", [], {}], "alpha": {"nested": {"deep": true}}})").parse();
+    const std::string bytes = jibby::JsonSnapshot::encode(doc);
+    const jibby::JsonSnapshot snapshot(bytes);
+    const jibby::JsonSnapshotValue root = snapshot.root();
+    assert(root.isObject() && root.size() == 8);
+    assert(root["name"].asString() == "snapshot" && root["id"].asInt64() == -7);
+    assert(root["big"].asUInt64() == UINT64_MAX && root["ratio"].asNumber() == 0.25);
+    assert(!root["ok"].asBoolean() && root["none"].isNull() && root["alpha"]["nested"]["deep"].asBoolean());
+    assert(root["zeta"][1].asString() == "two" && root["zeta"][2].size() == 0 && root.contains("alpha"));
+    assert(!root.contains("missing") && !root["zeta"].contains("0"));
+
+    // Strings are read in place, iteration keeps insertion order, and the copy back is exact
+    const std::string_view name = root["name"].asString();
+    assert(name.data() > bytes.data() && name.data() < bytes.data() + bytes.size());
+    std::vector<std::string_view> keys;
+    for (const auto& [key, value] : root) keys.push_back(key);
+    assert(keys.front() == "name" && keys.back() == "alpha");
+    assert(root.toJson().serialize() == doc.serialize());
+
+    // Binary search over a larger object
+    Json wide = Json::object();
+    for (int i = 0; i < 500; ++i) wide[std::to_string(i * 7919 % 1000)] = i;
+    const std::string wideBytes = jibby::JsonSnapshot::encode(wide);
+    const jibby::JsonSnapshot wideSnapshot(wideBytes);
+    for (int i = 0; i < 500; ++i) assert(wideSnapshot.root()[std::to_string(i * 7919 % 1000)].asInt64() == i);
+    assert(!wideSnapshot.root().contains("1000"));
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "jibby_snapshot_test.bin";
+    doc.saveSnapshot(path.string());
+    {
+        const jibby::JsonSnapshot loaded = Json::loadSnapshot(path.string());
+        assert(loaded.root()["zeta"][0].asInt64() == 1 && loaded.root().toJson().serialize() == doc.serialize());
+    }
+    std::filesystem::remove(path);
+
+    expectThrows([] { jibby::JsonSnapshot("{\"not\": \"a snapshot\"} padding padding"); }, "Not a Jibby snapshot", "testReadsSnapshots");
+    expectThrows([&] { jibby::JsonSnapshot(std::string_view(bytes).substr(0, bytes.size() - 8)); }, "Truncated", "testReadsSnapshots");
+    std::string damaged = jibby::JsonSnapshot::encode(JsonParser("[[1]]").parse());
+    damaged[32] = '\x08'; // point the root array's block back at the header
+    const jibby::JsonSnapshot broken(damaged);
+    expectThrows([&] { broken.root()[0]; }, "Corrupt snapshot", "testReadsSnapshots");
+    expectThrows([&] { root["name"].asInt64(); }, "not an int64", "testReadsSnapshots");
+}
+
+void testCountsAllocationsPerValue() {
+    CountingResource counter;
+    const auto allocationsFor = [&](const std::string& text) {
+        const size_t before = counter.allocations;
+        const Json value = JsonParser(text, &counter).parse();
+        return counter.allocations - before;
+    };
+
+    // Scalars, short strings and short keys live inside the values themselves
+    for (const char* text : {"123", "-1.5e3", "true", "null", "\"short\"", "[]", "{}"}) {
+        assert(allocationsFor(text) == 0);
+    }
+    // One for a long string's text and one per array; an object's members and index share two
+    assert(allocationsFor("\"a string too long for the small buffer\"") == 1);
+    assert(allocationsFor("[1, 2.5, \"three\", false]") == 1);
+    assert(allocationsFor(R"({"id": 1, "name": "short", "ok": true})") == 2);
+    assert(allocationsFor(R"({"a key longer than the inline capacity": 1})") == 3);
+
+    // Nothing per element beyond that, however large the containers grow
+    std::string records = "[";
+    std::string wide = "{";
+    for (int i = 0; i < 1000; ++i) {
+        if (i > 0) records += ",", wide += ",";
+        records += R"({"id": )" + std::to_string(i) + R"(, "tags": ["a", "b"]})";
+        wide += "\"k" + std::to_string(i) + "\": " + std::to_string(i);
+    }
+    records += "]";
+    wide += "}";
+    assert(allocationsFor(records) == 1 + 1000 * 3);
+    assert(allocationsFor(wide) == 2);
+
+    // Moving strings and containers in and out never copies them
+    Json doc = JsonParser(records, &counter).parse();
+    jibby::JsonString text("a string too long for the small buffer", &counter);
+    const size_t before = counter.allocations;
+    jibby::Array arr = doc.takeArray();
+    assert(doc.isNull() && arr.size() == 1000);
+    Json moved(std::move(arr));
+    doc = moved[2].takeObject();
+    moved[3] = std::move(text);
+    Json tags = std::move(moved[4]["tags"]);
+    assert(counter.allocations == before);
+    assert(doc["id"].asInt64() == 2 && moved[2].isNull() && tags.asArray().size() == 2);
+    assert(std::string_view(moved[3].asString()) == "a string too long for the small buffer");
+
+    // Emplacing builds the value where it will live; an existing member is left alone
+    assert(moved[0].emplace("extra", "value").asString() == "value");
+    assert(moved[0].emplace("id", 99).asInt64() == 0 && moved[0].asObject().size() == 3);
+    assert(moved.emplace_back(std::move(tags)).asArray().size() == 2 && moved.asArray().size() == 1001);
+    assert(Json::object().emplace("nested").isNull());
+    expectThrows([&] { moved.emplace("key"); }, "not an object", "testCountsAllocationsPerValue");
+    expectThrows([&] { moved.takeString(); }, "not a string", "testCountsAllocationsPerValue");
+}
+
+void testCollectsStats() {
+    const std::string text = "{\"a\":[1,2.5,true,null],\"b\":\"x\\ny\",\"c\":{}}";
+    jibby::JsonCountingResource counter;
+    jibby::JsonParseStats parseStats;
+    parseStats.timeTokenizer = true;
+    JsonParser parser(text, &counter);
+    parser.collect(parseStats);
+    const Json parsed = parser.parse();
+
+    std::string out;
+    jibby::JsonWriteStats writeStats;
+    jibby::JsonWriter writer(out);
+    writer.collect(writeStats);
+    writer.write(parsed);
+
+    if (!jibby::JsonParseStats::ENABLED) {
+        // Compiled out: nothing is counted, and nothing else changes
+        assert(parseStats.parses == 0 && parseStats.tokens == 0 && writeStats.writes == 0);
+        assert(out == parsed.serialize());
+        return;
+    }
+
+    // Every token is counted, including the first, read before collect() was called
+    assert(parseStats.parses == 1 && parseStats.bytes == text.size() && parseStats.tokens == 22);
+    assert(parseStats.objects == 2 && parseStats.arrays == 1 && parseStats.members == 3 && parseStats.maxDepth == 2);
+    assert(parseStats.strings == 4 && parseStats.stringBytes == 7);
+    assert(parseStats.escapedStrings == 1 && parseStats.unescapedBytes == 3);
+    assert(parseStats.numbers == 2 && parseStats.literals == 2);
+    assert(parseStats.allocations > 0 && parseStats.allocations == counter.allocations());
+    assert(parseStats.seconds >= parseStats.tokenizeSeconds && parseStats.tokenizeSeconds > 0.0);
+
+    assert(writeStats.writes == 1 && writeStats.bytes == out.size());
+    assert(writeStats.objects == 2 && writeStats.arrays == 1 && writeStats.members == 3 && writeStats.maxDepth == 2);
+    assert(writeStats.strings == 4 && writeStats.stringBytes == 6 && writeStats.escapes == 1);
+    assert(writeStats.numbers == 2 && writeStats.literals == 2);
+
+    // Counts add up across parses, the deepest nesting is kept
+    JsonParser deeper("[[[\"\"]]]");
+    deeper.collect(parseStats);
+    deeper.validate();
+    assert(parseStats.parses == 2 && parseStats.maxDepth == 2 && parseStats.tokens == 29 && parseStats.strings == 5);
+    jibby::JsonParseStats total;
+    total += parseStats;
+    total += parseStats;
+    assert(total.tokens == 58 && total.maxDepth == 2);
+
+    // Exported by name, or as an object
+    std::vector<std::pair<std::string, double>> metrics;
+    parseStats.report([&](std::string_view name, double value) { metrics.emplace_back(name, value); });
+    assert(std::find(metrics.begin(), metrics.end(), std::make_pair(std::string("string_bytes"), 7.0)) != metrics.end());
+    assert(std::any_of(metrics.begin(), metrics.end(), [](const auto& metric) { return metric.first == "build_seconds"; }));
+    const Json exported = writeStats.toJson();
+    assert(exported["escapes"].asUInt64() == 1 && exported["bytes"].asUInt64() == out.size());
+}
+
+void testIteratesWithoutCopies() {
+    // Dereferencing builds a pair, so member iterators can only claim to be input iterators
+    using Input = std::input_iterator_tag;
+    using RandomAccess = std::random_access_iterator_tag;
+    static_assert(std::is_same_v<std::iterator_traits<jibby::JsonIterator>::iterator_category, Input>);
+    static_assert(std::is_same_v<std::iterator_traits<jibby::JsonConstIterator>::iterator_category, Input>);
+    static_assert(std::is_same_v<std::iterator_traits<decltype(Json().elements().begin())>::iterator_category, RandomAccess>);
+
+    std::string text = "{";
+    for (int i = 0; i < 40; ++i) {
+        if (i > 0) text += ",";
+        text += "\"a key longer than the inline buffer " + std::to_string(i) + "\":" + std::to_string(i);
+    }
+    text += "}";
+    Json root = JsonParser(text).parse();
+
+    // Keys are views of the stored keys, not copies
+    size_t count = 0;
+    for (auto [key, value] : root) {
+        const jibby::JsonKey& stored = (root.asObject().begin() + static_cast<std::ptrdiff_t>(count))->first;
+        assert(key.data() == stored.data() && value.asInt64() == static_cast<int64_t>(count));
+        value = value.asInt64() * 2;
+        ++count;
+    }
+    assert(count == 40 && root["a key longer than the inline buffer 39"].asInt64() == 78);
+
+    // Constant-time steps and distances all the same, and conversion to a const iterator
+    const jibby::JsonConstIterator first = root.begin();
+    assert(root.end() - first == 40 && first[5].first == "a key longer than the inline buffer 5");
+    assert((first + 10)->second.asInt64() == 20 && first < root.end() && (root.end() - 1).key().back() == '9');
+    const auto found = std::find_if(root.begin(), root.end(), [](auto member) { return member.second.asInt64() == 60; });
+    assert(found - root.begin() == 30);
+
+    // Typed ranges: members as pairs, elements as the values themselves
+    const Json& constRoot = root;
+    assert(constRoot.members().size() == 40 && constRoot.members()[1].second.asInt64() == 2);
+    Json numbers = JsonParser("[5, 3, 9, 1]").parse();
+    auto elements = numbers.elements();
+    std::sort(elements.begin(), elements.end(), [](const Json& a, const Json& b) { return a.asInt64() < b.asInt64(); });
+    assert(numbers.serialize() == "[1,3,5,9]" && elements[3].asInt64() == 9);
+    for (auto [key, value] : numbers) assert(key.empty() && value.isNumber());
+    const Json empty = Json::array();
+    assert(Json::object().members().empty() && empty.begin() == empty.end());
+
+    expectThrows([&] { numbers.members(); }, "not an object", "testIteratesWithoutCopies");
+    expectThrows([&] { root.elements(); }, "not an array", "testIteratesWithoutCopies");
+}
+
+void testPushParsesInPieces() {
+    // Serialized result or error message, with the input fed in pieces of at most step bytes,
+    // the first of them first bytes long
+    const auto pushed = [](const std::string& text, size_t first, size_t step) -> std::string {
+        try {
+            jibby::JsonPushParser parser;
+            size_t pos = 0;
+            for (size_t size = first; pos < text.size(); size = step) {
+                const size_t length = std::min(size, text.size() - pos);
+                // A copy, so nothing can read a piece after it was fed
+                const std::string piece = text.substr(pos, length);
+                parser.feed(piece.data(), piece.size());
+                pos += length;
+            }
+            parser.finish();
+            return parser.result().serialize();
+        } catch (const jibby::JsonParseException& ex) {
+            return std::string("error: ") + ex.what();
+        }
+    };
+    const auto pulled = [](const std::string& text) -> std::string {
+        try {
+            return JsonParser(text).parse().serialize();
+        } catch (const jibby::JsonParseException& ex) {
+            return std::string("error: ") + ex.what();
+        }
+    };
+
+    const std::vector<std::string> documents = {
+        "{\"name\": \"caf\\u00e9 \\\"quoted\\\"\\n\", \"list\": [1, -2.5e3, 18446744073709551615, true, false, null],\n"
+            "  \"nested\": {\"empty\": {}, \"none\": [], \"deep\": [[[\"x\"]]]}, \"big\": 123456789012345678901234567890}",
+        "  -0.0001  ", "\"\"", "[]", "true", "12345",
+        // Errors, each of which must be reported with the same message and place
+        "", "   ", "{\"a\" 1}", "{\"a\":1,}", "{1:2}", "[1 2]", "[1,]", "{\"a\":1]", "[1}", "[1] x", "1 2",
+        "\"unterminated", "\"bad \\q escape\"", "\"bad \\u12G4\"", "\"cut \\", "\"cut \\u12", "\"ctl \n\"",
+        "01", "-", "1.", "1e", "1x", "1.2.3", "tru", "nul x", "trueish", "@", "[\n  1,\n  2,\n  oops\n]",
+    };
+    for (const std::string& text : documents) {
+        const std::string expected = pulled(text);
+        assert(pushed(text, text.size() + 1, 1) == expected);
+        assert(pushed(text, 1, 1) == expected);
+        for (size_t split = 0; split <= text.size(); ++split) {
+            if (pushed(text, split, text.size() + 1) != expected) {
+                std::cerr << "testPushParsesInPieces: split " << split << " of " << text << ": "
+                          << pushed(text, split, text.size() + 1) << " vs " << expected << '\n';
+                assert(false);
+            }
+        }
+    }
+
+    // Events, with skipping and stopping as for JsonParser::parse(JsonHandler&)
+    const std::string events = "[{\"value\":1,\"detail\":{\"value\":100}},{\"name\":\"x\",\"value\":2}]";
+    SummingHandler sum;
+    jibby::JsonPushParser summing(sum);
+    for (char c : events) assert(summing.feed(&c, 1));
+    assert(summing.finish() && sum.total == 3 && sum.events == 9 && summing.consumed() == events.size());
+
+    SummingHandler stopped;
+    jibby::JsonPushParser stopping(stopped);
+    assert(!stopping.feed("[{\"value\":1},{\"stop\":true},{\"val"));
+    assert(!stopping.feed("ue\":2}] trailing") && !stopping.finish() && stopped.total == 1);
+
+    expectThrows([&] { stopping.result(); }, "builds no result", "testPushParsesInPieces");
+    jibby::JsonPushParser unfinished;
+    unfinished.feed("[1]");
+    expectThrows([&] { unfinished.result(); }, "before finish()", "testPushParsesInPieces");
+    unfinished.finish();
+    expectThrows([&] { unfinished.feed("[2]"); }, "after finish()", "testPushParsesInPieces");
+}
+
+void testReadsManyFiles() {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "jibby_many_test";
+    std::filesystem::create_directories(dir);
+    std::vector<std::string> paths;
+    for (int i = 0; i < 40; ++i) {
+        paths.push_back((dir / ("file" + std::to_string(i) + ".json")).string());
+        std::ofstream out(paths.back(), std::ios::binary);
+        if (i == 7) out << "{\"broken\": }";
+        else out << "{\"index\": " << i << ", \"name\": \"file" << i << "\"}";
+    }
+    paths.insert(paths.begin() + 20, (dir / "missing.json").string());
+
+    // Results in the order given, a bad file holding its own error; mapped or read alike
+    const auto check = [&](std::vector<jibby::JsonFileResult>& results) {
+        assert(results.size() == paths.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (i == 7) {
+                assert(!results[i].ok());
+                expectThrows([&] { results[i].get(); }, "line 1, column 12", "testReadsManyFiles");
+            } else if (i == 20) {
+                expectThrows([&] { results[i].get(); }, "missing.json", "testReadsManyFiles");
+            } else {
+                const int64_t index = static_cast<int64_t>(i < 20 ? i : i - 1);
+                assert(results[i].ok() && results[i].get()["index"].asInt64() == index);
+            }
+        }
+    };
+    std::vector<jibby::JsonFileResult> read = jibby::JsonIO::readMany(paths);
+    check(read);
+    jibby::JsonWorkerPool pool(3);
+    jibby::JsonReadOptions mapped;
+    mapped.pool = &pool;
+    mapped.mapThreshold = 0;
+    std::vector<jibby::JsonFileResult> mappedRead = jibby::JsonIO::readMany(paths, mapped);
+    check(mappedRead);
+
+    // Delivered in order on this thread, stopping when asked
+    size_t delivered = 0;
+    const bool finished = jibby::JsonIO::readMany(paths, [&](size_t index, jibby::JsonFileResult& result) {
+        assert(index == delivered++);
+        return index != 10 || !result.ok();
+    }, mapped);
+    assert(!finished && delivered == 11);
+
+    std::vector<std::future<Json>> futures = jibby::JsonIO::readManyAsync(paths, mapped);
+    assert(futures.size() == paths.size());
+    assert(futures[39].get()["name"].asString() == "file38");
+    expectThrows([&] { futures[7].get(); }, "Unexpected token", "testReadsManyFiles");
+    expectThrows([&] { futures[20].get(); }, "Failed to open", "testReadsManyFiles");
+
+    // With no pool given, on the shared one
+    std::vector<std::future<Json>> shared = jibby::JsonIO::readManyAsync(paths);
+    assert(shared[0].get()["index"].asInt64() == 0 && shared[40].get()["name"].asString() == "file39");
+    expectThrows([&] { shared[20].get(); }, "Failed to open", "testReadsManyFiles");
+
+    std::filesystem::remove_all(dir);
+}
+
 } // namespace
 
 int main() {
     testLoadAndSaveRoundTrip();
+    testStringAccessors();
     testRejectsTrailingContent();
     testEscapesStringsOnSerialize();
     testUnicodeEscapesParse();
     testRejectsInvalidStringsAndNumbers();
+    testParsesCallerOwnedBuffer();
+    testScannerKernelsAgree();
+    testReportsErrorLocation();
+    testNumbersRoundTripExactly();
+    testIntegersStayExact();
+    testDoublesSerializeShortestRoundTrip();
+    testWriterSinks();
+    testDocumentAllocatesFromArena();
+    testObjectsKeepInsertionOrder();
+    testKeysAreInterned();
+    testHandlerEvents();
+    testStreamsAcrossChunks();
+    testReadsMappedFiles();
+    testReadsRecordsInParallel();
+    testParsesLargeArrayInParallel();
+    testLazyDocumentDecodesOnDemand();
+    testProjectsPaths();
+    testResolvesJsonPointers();
+    testEncodesBinaryFormats();
+    testReadsSnapshots();
+    testCountsAllocationsPerValue();
+    testCollectsStats();
+    testIteratesWithoutCopies();
+    testPushParsesInPieces();
+    testReadsManyFiles();
 
     std::cout << "All tests passed.\n";
     return 0;